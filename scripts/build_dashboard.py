@@ -0,0 +1,73 @@
+# Pre-build step: minify and gzip the dashboard HTML from src/web_dashboard.h into a PROGMEM byte
+# array with a content hash (src/web_dashboard_gz.h, generated, not committed). ota_server.cpp
+# serves it with Content-Encoding: gzip and a strong ETag, and answers revalidations with 304.
+#
+# Runs from platformio.ini (extra_scripts = pre:scripts/build_dashboard.py) or by hand:
+#   python scripts/build_dashboard.py
+# The output is only rewritten when its content changes, so it does not force rebuilds.
+
+import gzip
+import hashlib
+import os
+import re
+
+try:
+    Import("env")  # noqa: F821 (provided by PlatformIO/SCons)
+    PROJECT_DIR = env.subst("$PROJECT_DIR")  # noqa: F821
+except NameError:
+    PROJECT_DIR = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+SOURCE = os.path.join(PROJECT_DIR, "src", "web_dashboard.h")
+OUTPUT = os.path.join(PROJECT_DIR, "src", "web_dashboard_gz.h")
+
+
+def extract_html(text):
+    match = re.search(r'R"html\((.*?)\)html"', text, re.S)
+    if not match:
+        raise SystemExit("build_dashboard: no R\"html(...)html\" literal in " + SOURCE)
+    return match.group(1)
+
+
+def minify(html):
+    # Conservative: drop indentation, trailing whitespace, blank lines and HTML comments. Line
+    # breaks stay, so inline JS relying on automatic semicolon insertion keeps working.
+    html = re.sub(r"<!--.*?-->", "", html, flags=re.S)
+    lines = (line.strip() for line in html.splitlines())
+    return "\n".join(line for line in lines if line)
+
+
+def render(data, etag, raw_len):
+    rows = []
+    for i in range(0, len(data), 16):
+        rows.append("  " + ", ".join("0x%02x" % b for b in data[i:i + 16]) + ",")
+    return (
+        "#pragma once\n\n"
+        "// Generated by scripts/build_dashboard.py from web_dashboard.h - do not edit\n"
+        "// %u bytes minified, %u gzipped\n\n"
+        "#include <Arduino.h>\n\n"
+        "#define DASHBOARD_GZ_AVAILABLE 1\n\n"
+        "static const char DASHBOARD_ETAG[] = \"\\\"%s\\\"\";\n"
+        "static const size_t DASHBOARD_GZ_LEN = %u;\n"
+        "static const uint8_t DASHBOARD_GZ[] PROGMEM = {\n%s\n};\n"
+        % (raw_len, len(data), etag, len(data), "\n".join(rows))
+    )
+
+
+def main():
+    with open(SOURCE, "r", encoding="utf-8") as f:
+        html = minify(extract_html(f.read())).encode("utf-8")
+    data = gzip.compress(html, compresslevel=9, mtime=0)  # mtime=0: same input, same bytes
+    etag = hashlib.sha256(html).hexdigest()[:16]
+    content = render(data, etag, len(html))
+
+    old = None
+    if os.path.exists(OUTPUT):
+        with open(OUTPUT, "r", encoding="utf-8") as f:
+            old = f.read()
+    if old != content:
+        with open(OUTPUT, "w", encoding="utf-8") as f:
+            f.write(content)
+    print("build_dashboard: %u -> %u bytes gzipped, ETag %s" % (len(html), len(data), etag))
+
+
+main()
@@ -0,0 +1,54 @@
+#include "boot_profile.h"
+#include "processor.h" // LOGFLN
+#include <atomic>
+#include <string.h>
+
+namespace
+{
+  BootStage stages[BOOT_MAX_STAGES];
+  std::atomic<uint32_t> stageCount{0}; // entries below this are complete
+} // namespace
+
+void BootMark(const char *name)
+{
+  const uint32_t now = hal::Micros();
+  const uint32_t n = stageCount.load(std::memory_order_relaxed);
+  if (n >= BOOT_MAX_STAGES)
+    return;
+  for (uint32_t i = 0; i < n; ++i)
+    if (strcmp(stages[i].name, name) == 0)
+      return;
+  stages[n] = BootStage{name, now};
+  stageCount.store(n + 1, std::memory_order_release);
+}
+
+size_t BootStageCount()
+{
+  return stageCount.load(std::memory_order_acquire);
+}
+
+BootStage BootStageAt(size_t i)
+{
+  return i < BootStageCount() ? stages[i] : BootStage{"", 0};
+}
+
+uint32_t BootReadyUs()
+{
+  const size_t n = BootStageCount();
+  for (size_t i = 0; i < n; ++i)
+    if (strcmp(stages[i].name, "ready") == 0)
+      return stages[i].us;
+  return 0;
+}
+
+void BootPrintTimeline()
+{
+  const size_t n = BootStageCount();
+  uint32_t prev = 0;
+  LOGFLN("Boot timeline (%u stages, us since reset):", (unsigned)n);
+  for (size_t i = 0; i < n; ++i)
+  {
+    LOGFLN("  %-14s %9u  +%u", stages[i].name, (unsigned)stages[i].us, (unsigned)(stages[i].us - prev));
+    prev = stages[i].us;
+  }
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+// Boot timeline: BootMark("stage") records hal::Micros() for a named stage into a static table, so
+// cold-start time can be broken down (serial, processor, WiFi, OTA) and compared across releases.
+// The table is printed by the `boot` command and served as JSON at /api/boot.
+// Marks come from setup()/loop() only; readers on other threads see a consistent prefix.
+
+#include "hal.h"
+
+#ifndef BOOT_MAX_STAGES
+  #define BOOT_MAX_STAGES 16 // later marks are ignored once full
+#endif
+
+struct BootStage {
+  const char *name; // static storage (string literal)
+  uint32_t us;      // since reset (micros())
+};
+
+// Record a stage once; repeated marks of the same name keep the first time
+void BootMark(const char *name);
+
+size_t BootStageCount();
+BootStage BootStageAt(size_t i);
+
+// Time from reset to the "ready" stage (motor and button live), 0 until it is marked
+uint32_t BootReadyUs();
+
+// LOGFLN the timeline, one stage per line with the delta from the previous stage
+void BootPrintTimeline();
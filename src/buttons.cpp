@@ -0,0 +1,142 @@
+#include "buttons.h"
+#include "spsc_ring.h"
+#include "trace.h"
+
+namespace
+{
+  constexpr uint32_t DEBOUNCE_US = (uint32_t)BUTTON_DEBOUNCE_MS * 1000u;
+  static_assert(BUTTON_MAX <= 32, "pending buttons are tracked in a 32-bit mask");
+
+  struct Edge
+  {
+    uint32_t us;
+    uint8_t button;
+    bool level; // pin level read in the ISR, after the edge
+  };
+  // Producer: the GPIO ISR (all button interrupts are attached from one core, so never concurrent)
+  SpscRing<Edge, BUTTON_EDGE_RING> edges;
+  std::atomic<bool> overflow[BUTTON_MAX];
+  std::atomic<bool> anyOverflow{false};
+
+  // Consumer-side debounce state
+  struct Button
+  {
+    int pin;
+    bool stable;       // debounced level (true = released)
+    bool pendingLevel; // level since the last edge, not yet held for the window
+    bool resample;     // edges were lost: read the pin once the window has passed
+    uint32_t sinceUs;
+  };
+  Button buttons[BUTTON_MAX];
+  uint8_t attached = 0;
+  uint32_t pendingMask = 0; // buttons waiting out their debounce window
+  ButtonStats stats;
+
+  void HAL_ISR_ATTR OnEdge(void *arg)
+  {
+    const uint8_t i = (uint8_t)(uintptr_t)arg;
+    const Edge e{hal::Micros(), i, hal::GpioRead(buttons[i].pin)};
+    if (!edges.Push(e))
+    {
+      overflow[i].store(true, std::memory_order_relaxed);
+      anyOverflow.store(true, std::memory_order_release);
+    }
+  }
+
+  inline bool Held(uint32_t fromUs, uint32_t toUs)
+  {
+    return (int32_t)(toUs - fromUs) >= (int32_t)DEBOUNCE_US; // signed: an edge may be newer than nowUs
+  }
+
+  void Arm(uint8_t i, uint32_t sinceUs, bool level, bool resample)
+  {
+    Button &b = buttons[i];
+    b.pendingLevel = level;
+    b.resample = resample;
+    b.sinceUs = sinceUs;
+    pendingMask |= 1u << i;
+  }
+
+  // The pending level held for the whole window; true if that completes a press
+  bool Settle(uint8_t i)
+  {
+    Button &b = buttons[i];
+    pendingMask &= ~(1u << i);
+    const bool level = b.resample ? hal::GpioRead(b.pin) : b.pendingLevel;
+    if (level == b.stable)
+      return false;
+    b.stable = level;
+    if (level)
+      return false;
+    ++stats.presses;
+    return true;
+  }
+} // namespace
+
+uint8_t ButtonsAttach(int pin)
+{
+  uint8_t i = 0;
+  while (i < attached && buttons[i].pin != pin)
+    ++i;
+  if (i == BUTTON_MAX)
+    return BUTTON_NONE;
+  if (i == attached)
+    ++attached; // otherwise re-initialise the existing button, e.g. on processor re-init
+  hal::GpioInputPullup(pin);
+  buttons[i] = Button{pin, hal::GpioRead(pin), true, false, 0};
+  pendingMask &= ~(1u << i);
+  overflow[i].store(false, std::memory_order_relaxed);
+  hal::GpioAttachChangeInterrupt(pin, OnEdge, (void *)(uintptr_t)i);
+  return i;
+}
+
+bool ButtonsPoll(uint32_t nowUs, uint8_t &button)
+{
+  // Replay queued edges in order; each one ends the previous level's window
+  while (const Edge *e = edges.Peek())
+  {
+    const uint8_t i = e->button;
+    const bool pressed = (pendingMask & (1u << i)) && Held(buttons[i].sinceUs, e->us) && Settle(i);
+    Arm(i, e->us, e->level, false);
+    TRACE_AT(e->us, TraceEvent::BUTTON, i, e->level);
+    edges.Pop();
+    ++stats.edges;
+    if (pressed)
+    {
+      button = i;
+      return true;
+    }
+  }
+
+  // Lost edges (newer than anything replayed above): restart that button's window now and
+  // trust the pin once it has passed
+  if (anyOverflow.load(std::memory_order_acquire))
+  {
+    anyOverflow.store(false, std::memory_order_relaxed);
+    for (uint8_t i = 0; i < attached; ++i)
+    {
+      if (!overflow[i].load(std::memory_order_relaxed))
+        continue;
+      overflow[i].store(false, std::memory_order_relaxed);
+      Arm(i, nowUs, buttons[i].stable, true);
+      ++stats.overflows;
+    }
+  }
+
+  // Buttons whose last level has now held long enough
+  for (uint32_t m = pendingMask; m; m &= m - 1)
+  {
+    const uint8_t i = (uint8_t)__builtin_ctz(m);
+    if (Held(buttons[i].sinceUs, nowUs) && Settle(i))
+    {
+      button = i;
+      return true;
+    }
+  }
+  return false;
+}
+
+ButtonStats ButtonsGetStats()
+{
+  return stats;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+// Interrupt-driven, debounced push buttons (active low, internal pull-up).
+// A CHANGE interrupt on each button pin timestamps the edge into one lock-free ring; ButtonsPoll()
+// replays those edges against the debounce window, so a press is seen even if the consumer was
+// busy when it happened, and nothing reads a GPIO on the idle path. Cost per poll is one ring
+// check plus the buttons still settling, independent of how many buttons are attached.
+
+#include "hal.h"
+
+#ifndef BUTTON_MAX
+  #define BUTTON_MAX 8 // attachable buttons (start/stop plus room for presets)
+#endif
+
+#ifndef BUTTON_EDGE_RING
+  #define BUTTON_EDGE_RING 32 // queued edges across all buttons, power of two (covers contact bounce)
+#endif
+
+#ifndef BUTTON_DEBOUNCE_MS
+  #define BUTTON_DEBOUNCE_MS 30 // a level must hold this long to count
+#endif
+
+constexpr uint8_t BUTTON_NONE = 0xFF;
+
+// Configure the pin and attach its edge interrupt; returns the button index (BUTTON_NONE when full).
+// Attaching a pin again re-initialises the same button. Call while the consumer is not polling.
+uint8_t ButtonsAttach(int pin);
+
+// Consumer side (one thread): returns true and the button index for each debounced press, oldest
+// first; call until it returns false
+bool ButtonsPoll(uint32_t nowUs, uint8_t &button);
+
+struct ButtonStats {
+  uint32_t edges     = 0; // raw edges consumed (bounce included)
+  uint32_t presses   = 0;
+  uint32_t overflows = 0; // ring was full; that button was re-sampled after the window instead
+};
+ButtonStats ButtonsGetStats();
@@ -0,0 +1,420 @@
+#include "commands.h"
+#include "boot_profile.h"
+#include "status_channel.h"
+#include <string.h>
+
+namespace
+{
+  void PostOrWarn(ProcessorCommand cmd, float arg, CommandSource source)
+  {
+    if (!ProcessorPostCommand(cmd, arg, source))
+      LOGFLN("Command queue full - command dropped");
+  }
+
+  template <ProcessorCommand C>
+  void Post(const CommandArgs &args, const CommandContext &ctx)
+  {
+    PostOrWarn(C, args.number, ctx.source);
+  }
+
+  void Help(const CommandArgs &, const CommandContext &)
+  {
+    PrintCommandHelp();
+  }
+
+  void Boot(const CommandArgs &, const CommandContext &)
+  {
+    BootPrintTimeline();
+  }
+
+  // The replay and subscription queues have a single producer (the network task), and only a
+  // WebSocket client has anywhere to receive the frames
+  bool FromWebSocket(const CommandContext &ctx, const char *what)
+  {
+    if (ctx.source == CommandSource::NETWORK)
+      return true;
+    LOGFLN("%s is only available over the WebSocket", what);
+    return false;
+  }
+
+  void History(const CommandArgs &, const CommandContext &ctx)
+  {
+    if (!FromWebSocket(ctx, "history"))
+      return;
+    #if ENABLE_OTA
+      OtaRequestHistory(ctx.clientId, 0, true);
+    #endif
+  }
+
+  void HistorySince(const CommandArgs &args, const CommandContext &ctx)
+  {
+    if (!FromWebSocket(ctx, "history"))
+      return;
+    #if ENABLE_OTA
+      // A timestamp from the future means the device rebooted since the client last saw it
+      const bool all = args.uint > hal::Millis();
+      OtaRequestHistory(ctx.clientId, args.uint, all);
+    #else
+      (void)args;
+    #endif
+  }
+
+  // "subscribe <topic> <max Hz>": 0 Hz unsubscribes (status_channel.h)
+  void Subscribe(const CommandArgs &args, const CommandContext &ctx)
+  {
+    if (!FromWebSocket(ctx, "subscribe"))
+      return;
+    uint8_t topics;
+    if (!StatusTopicMask(args.key, args.keyLen, topics))
+    {
+      LOGFLN("Unknown topic - use motion, config, system, metrics or all");
+      return;
+    }
+    #if ENABLE_OTA
+      const bool on = args.number > 0.0f;
+      const float intervalMs = on ? 1000.0f / args.number + 0.5f : 0.0f;
+      OtaSubscribe(ctx.clientId, topics, on, intervalMs < (float)UINT32_MAX ? (uint32_t)intervalMs : UINT32_MAX);
+    #endif
+  }
+
+  // "telemetry <Hz>": binary duty/phase stream (telemetry.h); 0 stops it
+  void Telemetry(const CommandArgs &args, const CommandContext &ctx)
+  {
+    if (!FromWebSocket(ctx, "telemetry"))
+      return;
+    #if ENABLE_OTA
+      OtaTelemetry(ctx.clientId, args.uint);
+    #else
+      (void)args;
+    #endif
+  }
+
+  // "set <key> <value>": keys are few, so a linear scan is enough
+  struct Setting
+  {
+    const char *key;
+    ProcessorCommand cmd;
+    ProcessorCommand cmd2; // "ramp" sets both ramps; same as cmd otherwise
+  };
+  constexpr Setting SETTINGS[] = {
+    {"coast",     ProcessorCommand::SET_COAST_MS,     ProcessorCommand::SET_COAST_MS},
+    {"cruise",    ProcessorCommand::SET_CRUISE,       ProcessorCommand::SET_CRUISE},
+    {"fwd",       ProcessorCommand::SET_FORWARD_MS,   ProcessorCommand::SET_FORWARD_MS},
+    {"profile",   ProcessorCommand::SET_RAMP_PROFILE, ProcessorCommand::SET_RAMP_PROFILE},
+    {"ramp",      ProcessorCommand::SET_RAMP_UP_MS,   ProcessorCommand::SET_RAMP_DOWN_MS},
+    {"ramp_down", ProcessorCommand::SET_RAMP_DOWN_MS, ProcessorCommand::SET_RAMP_DOWN_MS},
+    {"ramp_up",   ProcessorCommand::SET_RAMP_UP_MS,   ProcessorCommand::SET_RAMP_UP_MS},
+    {"rev",       ProcessorCommand::SET_REVERSE_MS,   ProcessorCommand::SET_REVERSE_MS},
+  };
+
+  void Set(const CommandArgs &args, const CommandContext &ctx)
+  {
+    for (const Setting &s : SETTINGS)
+    {
+      if (strncmp(s.key, args.key, args.keyLen) == 0 && s.key[args.keyLen] == '\0')
+      {
+        PostOrWarn(s.cmd, args.number, ctx.source);
+        if (s.cmd2 != s.cmd)
+          PostOrWarn(s.cmd2, args.number, ctx.source);
+        return;
+      }
+    }
+    LOGFLN("Unknown setting - use coast, cruise, fwd, profile, ramp, ramp_down, ramp_up or rev");
+  }
+
+  // Sorted by strcmp() order (checked at compile time below); single characters are the serial shortcuts
+  constexpr CommandSpec COMMANDS[] = {
+    {"0",             CommandArg::NONE,      Post<ProcessorCommand::ALL_OFF>,     nullptr},
+    {"1",             CommandArg::NONE,      Post<ProcessorCommand::TEST_IN1>,    nullptr},
+    {"2",             CommandArg::NONE,      Post<ProcessorCommand::TEST_IN2>,    nullptr},
+    {"?",             CommandArg::NONE,      Help,                                nullptr},
+    {"a",             CommandArg::NONE,      Post<ProcessorCommand::AUTO_START>,  nullptr},
+    {"auto_start",    CommandArg::NONE,      Post<ProcessorCommand::AUTO_START>,  "start the auto forward/reverse cycle (a, start)"},
+    {"b",             CommandArg::NONE,      Post<ProcessorCommand::BRAKE_STOP>,  nullptr},
+    {"boot",          CommandArg::NONE,      Boot,                                "print the boot timeline (also /api/boot)"},
+    {"c",             CommandArg::NONE,      Post<ProcessorCommand::COAST_STOP>,  nullptr},
+    {"coast",         CommandArg::NONE,      Post<ProcessorCommand::COAST_STOP>,  nullptr},
+    {"f",             CommandArg::NONE,      Post<ProcessorCommand::MANUAL_FWD>,  nullptr},
+    {"help",          CommandArg::NONE,      Help,                                "list commands (?)"},
+    {"history",       CommandArg::NONE,      History,                             "replay the dashboard log history (WebSocket)"},
+    {"history_since", CommandArg::UINT,      HistorySince,                        "replay log lines newer than <ms> (WebSocket)"},
+    {"manual_fwd",    CommandArg::NONE,      Post<ProcessorCommand::MANUAL_FWD>,  "jog forward at cruise (f)"},
+    {"manual_rev",    CommandArg::NONE,      Post<ProcessorCommand::MANUAL_REV>,  "jog reverse at cruise (r)"},
+    {"motors_off",    CommandArg::NONE,      Post<ProcessorCommand::ALL_OFF>,     "both motor pins off (0)"},
+    {"p",             CommandArg::NONE,      Post<ProcessorCommand::PRINT_STATE>, nullptr},
+    {"print_status",  CommandArg::NONE,      Post<ProcessorCommand::PRINT_STATE>, "print state and statistics (p, status)"},
+    {"r",             CommandArg::NONE,      Post<ProcessorCommand::MANUAL_REV>,  nullptr},
+    {"set",           CommandArg::KEY_VALUE, Set,                                 "set fwd|rev <ms>, ramp|ramp_up|ramp_down|coast <ms>, cruise <%>, profile 0|1|2"},
+    {"set_cruise",    CommandArg::NUMBER,    Post<ProcessorCommand::SET_CRUISE>,  "set cruise duty <%> (u)"},
+    {"start",         CommandArg::NONE,      Post<ProcessorCommand::AUTO_START>,  nullptr},
+    {"status",        CommandArg::NONE,      Post<ProcessorCommand::PRINT_STATE>, nullptr},
+    {"stop",          CommandArg::NONE,      Post<ProcessorCommand::BRAKE_STOP>,  nullptr},
+    {"stop_brake",    CommandArg::NONE,      Post<ProcessorCommand::BRAKE_STOP>,  "brake stop (b, stop)"},
+    {"stop_coast",    CommandArg::NONE,      Post<ProcessorCommand::COAST_STOP>,  "ramp down and coast (c, coast)"},
+    {"subscribe",     CommandArg::KEY_VALUE, Subscribe,                           "subscribe motion|config|system|metrics|all <max Hz> (0 stops; WebSocket)"},
+    {"telemetry",     CommandArg::UINT,      Telemetry,                           "stream IN1/IN2 duty and phase as binary frames at <Hz> (0 stops; WebSocket)"},
+    {"test_in1",      CommandArg::NONE,      Post<ProcessorCommand::TEST_IN1>,    "drive IN1 only at 50% (1)"},
+    {"test_in2",      CommandArg::NONE,      Post<ProcessorCommand::TEST_IN2>,    "drive IN2 only at 50% (2)"},
+    {"u",             CommandArg::NUMBER,    Post<ProcessorCommand::SET_CRUISE>,  nullptr},
+  };
+  constexpr size_t COMMAND_COUNT = sizeof(COMMANDS) / sizeof(COMMANDS[0]);
+
+  // Recursive so it stays a valid constexpr under the esp32dev core's C++11 default
+  constexpr int CompareNames(const char *a, const char *b)
+  {
+    return (*a && *a == *b) ? CompareNames(a + 1, b + 1) : (unsigned char)*a - (unsigned char)*b;
+  }
+
+  constexpr bool TableIsSorted(size_t i = 1)
+  {
+    return i >= COMMAND_COUNT ||
+           (CompareNames(COMMANDS[i - 1].name, COMMANDS[i].name) < 0 && TableIsSorted(i + 1));
+  }
+  static_assert(TableIsSorted(), "COMMANDS must be sorted by name with no duplicates");
+
+  // strcmp() of a length-bounded key against a NUL-terminated table name
+  inline int CompareKey(const char *key, size_t len, const char *name)
+  {
+    for (size_t i = 0; i < len; ++i)
+    {
+      const unsigned char n = (unsigned char)name[i];
+      if (n == '\0')
+        return 1; // key is longer
+      if ((unsigned char)key[i] != n)
+        return (unsigned char)key[i] - n;
+    }
+    return name[len] == '\0' ? 0 : -1;
+  }
+
+  inline bool IsSpace(char c)
+  {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+  }
+} // namespace
+
+const CommandSpec *FindCommand(const char *name, size_t len)
+{
+  size_t lo = 0;
+  size_t hi = COMMAND_COUNT;
+  while (lo < hi)
+  {
+    const size_t mid = (lo + hi) / 2;
+    const int c = CompareKey(name, len, COMMANDS[mid].name);
+    if (c == 0)
+      return &COMMANDS[mid];
+    if (c < 0)
+      hi = mid;
+    else
+      lo = mid + 1;
+  }
+  return nullptr;
+}
+
+bool ParseNumberArg(const char *text, size_t len, float &out)
+{
+  size_t i = 0;
+  bool negative = false;
+  if (i < len && (text[i] == '-' || text[i] == '+'))
+    negative = (text[i++] == '-');
+
+  uint32_t whole = 0;
+  uint32_t frac = 0;
+  uint32_t fracScale = 1;
+  bool digits = false;
+  for (; i < len && text[i] >= '0' && text[i] <= '9'; ++i)
+  {
+    if (whole > 100000000u)
+      return false; // far outside any argument we take
+    whole = whole * 10 + (uint32_t)(text[i] - '0');
+    digits = true;
+  }
+  if (i < len && text[i] == '.')
+  {
+    for (++i; i < len && text[i] >= '0' && text[i] <= '9'; ++i)
+    {
+      if (fracScale < 1000000u) // ignore digits past 1e-6
+      {
+        frac = frac * 10 + (uint32_t)(text[i] - '0');
+        fracScale *= 10;
+      }
+      digits = true;
+    }
+  }
+  if (!digits || i != len)
+    return false;
+
+  out = (float)whole + (float)frac / (float)fracScale;
+  if (negative)
+    out = -out;
+  return true;
+}
+
+bool ParseUintArg(const char *text, size_t len, uint32_t &out)
+{
+  if (len == 0 || len > 10)
+    return false;
+  uint64_t v = 0;
+  for (size_t i = 0; i < len; ++i)
+  {
+    if (text[i] < '0' || text[i] > '9')
+      return false;
+    v = v * 10 + (uint64_t)(text[i] - '0');
+  }
+  if (v > UINT32_MAX)
+    return false;
+  out = (uint32_t)v;
+  return true;
+}
+
+CommandResult ParseCommand(const char *text, size_t len, ParsedCommand &out)
+{
+  // Trim surrounding whitespace (serial line endings, stray spaces)
+  while (len > 0 && IsSpace(text[0]))
+  {
+    ++text;
+    --len;
+  }
+  while (len > 0 && IsSpace(text[len - 1]))
+    --len;
+
+  size_t nameLen = 0;
+  while (nameLen < len && text[nameLen] != '=' && !IsSpace(text[nameLen]))
+    ++nameLen;
+
+  out.spec = FindCommand(text, nameLen);
+  if (!out.spec)
+    return CommandResult::UNKNOWN;
+
+  // Argument: everything after '=' or the run of spaces
+  size_t argStart = nameLen;
+  if (argStart < len && text[argStart] == '=')
+    ++argStart;
+  while (argStart < len && IsSpace(text[argStart]))
+    ++argStart;
+  const char *arg = text + argStart;
+  const size_t argLen = len - argStart;
+
+  out.args = CommandArgs();
+  switch (out.spec->arg)
+  {
+    case CommandArg::NONE:
+      return argLen == 0 ? CommandResult::OK : CommandResult::BAD_ARG;
+    case CommandArg::NUMBER:
+      if (argLen == 0)
+        return CommandResult::MISSING_ARG;
+      return ParseNumberArg(arg, argLen, out.args.number) ? CommandResult::OK : CommandResult::BAD_ARG;
+    case CommandArg::UINT:
+      if (argLen == 0)
+        return CommandResult::MISSING_ARG;
+      return ParseUintArg(arg, argLen, out.args.uint) ? CommandResult::OK : CommandResult::BAD_ARG;
+    case CommandArg::KEY_VALUE:
+    {
+      size_t keyLen = 0;
+      while (keyLen < argLen && arg[keyLen] != '=' && !IsSpace(arg[keyLen]))
+        ++keyLen;
+      size_t valueStart = keyLen;
+      if (valueStart < argLen && arg[valueStart] == '=')
+        ++valueStart;
+      while (valueStart < argLen && IsSpace(arg[valueStart]))
+        ++valueStart;
+      if (keyLen == 0 || valueStart == argLen)
+        return CommandResult::MISSING_ARG;
+      out.args.key = arg;
+      out.args.keyLen = keyLen;
+      return ParseNumberArg(arg + valueStart, argLen - valueStart, out.args.number) ? CommandResult::OK
+                                                                                     : CommandResult::BAD_ARG;
+    }
+  }
+  return CommandResult::BAD_ARG;
+}
+
+CommandResult DispatchCommand(const char *text, size_t len, const CommandContext &ctx)
+{
+  ParsedCommand parsed;
+  const CommandResult r = ParseCommand(text, len, parsed);
+  if (r == CommandResult::OK)
+    parsed.spec->handler(parsed.args, ctx);
+  return r;
+}
+
+void PrintCommandHelp()
+{
+  LOGFLN("Commands (name, name=arg or name arg):");
+  for (const CommandSpec &c : COMMANDS)
+  {
+    if (c.help)
+      LOGFLN("  %s - %s", c.name, c.help);
+  }
+}
+
+CommandLineEditor::Event CommandLineEditor::Feed(char c)
+{
+  if (lineReady_)
+  {
+    lineReady_ = false;
+    len_ = 0;
+  }
+
+  const bool lineEnd = (c == '\r' || c == '\n');
+  const char prevEnd = lastEnd_;
+  lastEnd_ = lineEnd ? c : 0;
+
+  switch (state_)
+  {
+    case State::ESCAPE:
+      state_ = (c == '[') ? State::CSI : (c == 'O') ? State::SS3 : State::TEXT;
+      return Event::NONE;
+    case State::CSI:
+      if (c >= 0x40 && c <= 0x7e) // final byte of the sequence
+        state_ = State::TEXT;
+      return Event::NONE;
+    case State::SS3: // ESC O x: arrow/function keys in application cursor mode
+      state_ = State::TEXT;
+      return Event::NONE;
+    case State::DISCARD:
+      if (lineEnd)
+      {
+        state_ = State::TEXT;
+        len_ = 0;
+      }
+      return Event::NONE;
+    case State::TEXT:
+      break;
+  }
+
+  if (lineEnd)
+  {
+    if (c == '\n' && prevEnd == '\r')
+      return Event::NONE; // second half of CRLF
+    buf_[len_] = '\0';
+    lineReady_ = true;
+    return Event::LINE;
+  }
+  if (c == '\b' || c == 0x7f)
+  {
+    if (len_ == 0)
+      return Event::NONE;
+    --len_;
+    return Event::ERASE;
+  }
+  if (c == 0x15) // Ctrl-U
+  {
+    len_ = 0;
+    return Event::CLEAR;
+  }
+  if (c == 0x1b)
+  {
+    state_ = State::ESCAPE;
+    return Event::NONE;
+  }
+  if ((unsigned char)c < 0x20)
+    return Event::NONE; // other control characters
+  if (len_ >= MAX_LINE)
+  {
+    state_ = State::DISCARD;
+    len_ = 0;
+    return Event::TOO_LONG;
+  }
+  buf_[len_++] = c;
+  return Event::ECHO;
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+// Shared command table for every transport (serial CLI, WebSocket).
+// Commands are "name", "name=arg" or "name arg"; names and aliases live in one sorted constexpr
+// table looked up by binary search, and arguments are parsed in place from the received bytes,
+// so dispatching never allocates.
+
+#include "processor.h"
+
+enum class CommandArg : uint8_t {
+  NONE,
+  NUMBER, // decimal, e.g. 65.5
+  UINT,     // unsigned integer, e.g. a millis() timestamp
+  KEY_VALUE // "<key> <number>" or "<key>=<number>", e.g. "fwd 8000"
+};
+
+struct CommandArgs {
+  float number = 0.0f;
+  uint32_t uint = 0;
+  const char *key = nullptr; // KEY_VALUE only; points into the received text, not NUL-terminated
+  size_t keyLen = 0;
+};
+
+// Where a command came from, so handlers can reply or pick the right queue
+struct CommandContext {
+  CommandSource source;
+  uint32_t clientId; // WebSocket client id (0 for the console)
+};
+
+typedef void (*CommandHandler)(const CommandArgs &args, const CommandContext &ctx);
+
+struct CommandSpec {
+  const char *name;
+  CommandArg arg;
+  CommandHandler handler;
+  const char *help; // nullptr for aliases
+};
+
+struct ParsedCommand {
+  const CommandSpec *spec = nullptr;
+  CommandArgs args;
+};
+
+enum class CommandResult : uint8_t {
+  OK,
+  UNKNOWN,
+  MISSING_ARG,
+  BAD_ARG
+};
+
+// Name lookup only (exact match on the first len bytes)
+const CommandSpec *FindCommand(const char *name, size_t len);
+
+// Split "name[=| ]arg", look the name up and parse the argument; does not run the handler
+CommandResult ParseCommand(const char *text, size_t len, ParsedCommand &out);
+
+// Parse and run
+CommandResult DispatchCommand(const char *text, size_t len, const CommandContext &ctx);
+
+// In-place argument parsers (no NUL terminator required); return false on malformed input
+bool ParseNumberArg(const char *text, size_t len, float &out);
+bool ParseUintArg(const char *text, size_t len, uint32_t &out);
+
+// LOGFLN one line per documented command
+void PrintCommandHelp();
+
+// Byte-at-a-time line editor for the serial console: Feed() never blocks and never allocates.
+// Handles backspace/DEL, Ctrl-U (clear line), CR, LF or CRLF line ends, and swallows ANSI escape
+// sequences (CSI and SS3: arrow keys in either cursor mode) so they don't end up in the command.
+class CommandLineEditor
+{
+public:
+  static constexpr size_t MAX_LINE = 64;
+
+  enum class Event : uint8_t {
+    NONE,     // byte consumed, nothing to show
+    ECHO,     // byte appended; echo it
+    ERASE,    // last byte removed; erase it on the terminal
+    CLEAR,    // whole line discarded
+    LINE,     // a complete line is ready in Line()/Length() until the next Feed()
+    TOO_LONG  // line too long; discarded up to the next line end
+  };
+
+  Event Feed(char c);
+  const char *Line() const { return buf_; }
+  size_t Length() const { return len_; }
+
+private:
+  enum class State : uint8_t { TEXT, ESCAPE, CSI, SS3, DISCARD };
+
+  char buf_[MAX_LINE + 1] = {};
+  size_t len_ = 0;
+  State state_ = State::TEXT;
+  bool lineReady_ = false;
+  char lastEnd_ = 0; // previous line end, so CRLF counts once
+};
+
+#if ENABLE_OTA
+  // Implemented in ota_server.cpp: queue a log history replay for a WebSocket client
+  void OtaRequestHistory(uint32_t clientId, uint32_t sinceMs, bool all);
+  // ... and a status subscription change (status_channel.h)
+  void OtaSubscribe(uint32_t clientId, uint8_t topics, bool on, uint32_t intervalMs);
+  // ... and a binary telemetry rate change (telemetry.h)
+  void OtaTelemetry(uint32_t clientId, uint32_t hz);
+#endif
@@ -0,0 +1,203 @@
+#include "deferred_log.h"
+#include <stdio.h>
+#include <string.h>
+
+SpscRing<LogRecord, LOG_RING_SIZE> logRings[LOG_PRODUCERS];
+std::atomic<uint32_t> logDropped[LOG_PRODUCERS];
+
+#if LOG_PRODUCERS > 1
+  thread_local uint8_t logdetail::producer = (uint8_t)LogProducer::MAIN;
+#endif
+
+namespace
+{
+  uint32_t highWater = 0;
+  uint32_t droppedReported = 0;
+
+  uint32_t TotalDropped()
+  {
+    uint32_t n = 0;
+    for (const auto &d : logDropped)
+      n += d.load(std::memory_order_relaxed);
+    return n;
+  }
+
+  // Ring whose oldest record is earliest, so lines from different threads come out in order
+  SpscRing<LogRecord, LOG_RING_SIZE> *OldestRing()
+  {
+    SpscRing<LogRecord, LOG_RING_SIZE> *best = nullptr;
+    uint32_t bestTs = 0;
+    for (auto &ring : logRings)
+    {
+      const LogRecord *rec = ring.Peek();
+      if (rec && (!best || (int32_t)(rec->timestampMs - bestTs) < 0))
+      {
+        best = &ring;
+        bestTs = rec->timestampMs;
+      }
+    }
+    return best;
+  }
+
+  inline bool IsConversion(char c)
+  {
+    return strchr("diouxXcsfFeEgGaA", c) != nullptr;
+  }
+
+  // snprintf one conversion spec (e.g. "%.1f", "%lu") with a captured argument, casting it to the
+  // type the spec asks for; mismatched kinds are converted rather than reinterpreted
+  int FormatArg(char *out, size_t cap, const char *spec, char conv, int longs, LogArgKind kind,
+                const LogArgValue &arg)
+  {
+    const bool isUnsigned = strchr("ouxX", conv) != nullptr;
+    switch (conv)
+    {
+      case 's':
+        return snprintf(out, cap, spec, kind == LogArgKind::STR && arg.s ? arg.s : "(null)");
+      case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+      {
+        double d = kind == LogArgKind::DOUBLE ? arg.d
+                 : kind == LogArgKind::UINT   ? (double)arg.u
+                 : kind == LogArgKind::INT    ? (double)arg.i
+                                              : 0.0;
+        return snprintf(out, cap, spec, d);
+      }
+      default:
+      {
+        int64_t v = kind == LogArgKind::DOUBLE ? (int64_t)arg.d
+                  : kind == LogArgKind::STR    ? 0
+                                               : arg.i;
+        if (longs >= 2)
+          return isUnsigned ? snprintf(out, cap, spec, (unsigned long long)v) : snprintf(out, cap, spec, (long long)v);
+        if (longs == 1)
+          return isUnsigned ? snprintf(out, cap, spec, (unsigned long)v) : snprintf(out, cap, spec, (long)v);
+        return isUnsigned ? snprintf(out, cap, spec, (unsigned)v) : snprintf(out, cap, spec, (int)v);
+      }
+    }
+  }
+
+  void Emit(const char *line, bool newline, uint32_t timestampMs)
+  {
+    #if defined(ARDUINO)
+      Serial.print(line);
+      if (newline)
+      {
+        Serial.println();
+        OtaLogLine(line, timestampMs);
+      }
+    #else
+      hal::NativeLogLine(line, newline, timestampMs);
+    #endif
+  }
+} // namespace
+
+size_t LogFormat(const LogRecord &rec, char *out, size_t cap)
+{
+  if (cap == 0)
+    return 0;
+  size_t n = 0;
+  uint8_t argi = 0;
+  const char *p = rec.fmt;
+
+  while (*p && n + 1 < cap)
+  {
+    if (*p != '%')
+    {
+      out[n++] = *p++;
+      continue;
+    }
+    if (p[1] == '%')
+    {
+      out[n++] = '%';
+      p += 2;
+      continue;
+    }
+
+    // Collect one spec: flags, width, precision, length modifiers, conversion
+    char spec[16];
+    size_t sl = 0;
+    int longs = 0;
+    spec[sl++] = *p++;
+    while (*p && !IsConversion(*p) && sl < sizeof(spec) - 2)
+    {
+      if (*p == 'l')
+        ++longs;
+      if (*p != 'h' && *p != 'z' && *p != 'j' && *p != 't')
+        spec[sl++] = *p;
+      ++p;
+    }
+    if (!*p)
+      break;
+    const char conv = *p++;
+    if (longs > 2)
+      longs = 2;
+    spec[sl++] = conv;
+    spec[sl] = '\0';
+
+    if (argi >= rec.argc)
+      break; // more specs than captured args
+    int w = FormatArg(out + n, cap - n, spec, conv, longs, rec.kinds[argi], rec.args[argi]);
+    ++argi;
+    if (w < 0)
+      break;
+    n += (size_t)w;
+    if (n >= cap)
+      n = cap - 1; // truncated
+  }
+  out[n] = '\0';
+  return n;
+}
+
+void LogBindProducer(LogProducer producer)
+{
+  #if LOG_PRODUCERS > 1
+    logdetail::producer = (uint8_t)producer;
+  #else
+    (void)producer;
+  #endif
+}
+
+void LogDrain(size_t maxRecords)
+{
+  for (const auto &ring : logRings)
+  {
+    const uint32_t queued = (uint32_t)ring.Size();
+    if (queued > highWater)
+      highWater = queued;
+  }
+
+  char line[LOG_LINE_MAX];
+  const uint32_t dropped = TotalDropped();
+  if (dropped != droppedReported)
+  {
+    snprintf(line, sizeof(line), "[log] %u records dropped (ring full)", (unsigned)(dropped - droppedReported));
+    droppedReported = dropped;
+    Emit(line, true, hal::Millis());
+  }
+
+  for (size_t i = 0; i < maxRecords; ++i)
+  {
+    SpscRing<LogRecord, LOG_RING_SIZE> *ring = OldestRing();
+    if (!ring)
+      break;
+    const LogRecord *rec = ring->Peek();
+    LogFormat(*rec, line, sizeof(line));
+    const bool newline = rec->newline;
+    const uint32_t ts = rec->timestampMs;
+    ring->Pop();
+    Emit(line, newline, ts);
+  }
+}
+
+LogStats LogGetStats()
+{
+  LogStats st;
+  st.dropped = TotalDropped();
+  st.highWater = highWater;
+  for (const auto &ring : logRings)
+  {
+    st.pending += (uint32_t)ring.Size();
+    st.capacity += (uint32_t)ring.Capacity();
+  }
+  return st;
+}
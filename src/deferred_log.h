@@ -0,0 +1,133 @@
+#pragma once
+
+// Deferred logging: LOGF/LOGFLN capture a binary record (format pointer, timestamp, raw args) into a
+// lock-free SPSC ring and return. LogDrain() formats queued records later, from loop() idle time,
+// and fans them out to Serial and the OTA dashboard, so nothing on the motor path waits on I/O.
+//
+// The format string and any %s arguments are stored by pointer, so they must outlive the drain:
+// pass string literals or other static storage, never String::c_str() temporaries.
+//
+// Each thread that logs (loop(), the processor task, the network task) gets its own ring so every
+// ring keeps exactly one producer. A thread picks its ring once with LogBindProducer(); threads that
+// never call it log to MAIN. LogDrain() merges the rings back into timestamp order.
+
+#include "hal.h"
+#include "spsc_ring.h"
+
+#ifndef LOG_RING_SIZE
+  #define LOG_RING_SIZE 32 // records per producer, power of two (64 bytes each)
+#endif
+
+// ESP8266 callbacks never preempt loop(), so one ring serves every context there
+#ifndef LOG_PRODUCERS
+  #if defined(ESP8266)
+    #define LOG_PRODUCERS 1
+  #else
+    #define LOG_PRODUCERS 3
+  #endif
+#endif
+
+enum class LogProducer : uint8_t {
+  MAIN,   // setup()/loop()
+  MOTOR,  // processor task
+  NETWORK // AsyncTCP callbacks
+};
+
+#ifndef LOG_DRAIN_PER_PASS
+  #define LOG_DRAIN_PER_PASS 4 // records formatted per LogDrain() call, bounds loop() latency
+#endif
+
+constexpr size_t LOG_MAX_ARGS = 6;
+constexpr size_t LOG_LINE_MAX = 192;
+
+enum class LogArgKind : uint8_t { INT, UINT, DOUBLE, STR };
+
+union LogArgValue
+{
+  int64_t i;
+  uint64_t u;
+  double d;
+  const char *s;
+};
+
+struct LogRecord
+{
+  const char *fmt;
+  uint32_t timestampMs;
+  uint8_t argc;
+  bool newline;
+  LogArgKind kinds[LOG_MAX_ARGS];
+  LogArgValue args[LOG_MAX_ARGS];
+};
+
+struct LogStats
+{
+  uint32_t dropped   = 0; // records lost because the ring was full
+  uint32_t highWater = 0; // most records seen queued in one producer's ring
+  uint32_t pending   = 0;
+  uint32_t capacity  = 0;
+};
+
+extern SpscRing<LogRecord, LOG_RING_SIZE> logRings[LOG_PRODUCERS];
+extern std::atomic<uint32_t> logDropped[LOG_PRODUCERS]; // each written by its ring's producer only
+
+// Route this thread's LOGF/LOGFLN to the producer's ring (no-op with a single ring)
+void LogBindProducer(LogProducer producer);
+
+// Format queued records and fan them out; call from loop()
+void LogDrain(size_t maxRecords = LOG_DRAIN_PER_PASS);
+
+// Render one record with its captured arguments; returns the formatted length
+size_t LogFormat(const LogRecord &rec, char *out, size_t cap);
+
+LogStats LogGetStats();
+
+// Web dashboard log mirroring (implemented in ota_server.cpp, no-op when ENABLE_OTA=0)
+void OtaLogLine(const char *message, uint32_t timestampMs);
+
+namespace logdetail
+{
+  #if LOG_PRODUCERS > 1
+    extern thread_local uint8_t producer;
+    inline size_t ProducerIndex() { return producer; }
+  #else
+    inline size_t ProducerIndex() { return 0; }
+  #endif
+
+  inline void Store(LogRecord &r, uint8_t i, int v) { r.kinds[i] = LogArgKind::INT; r.args[i].i = v; }
+  inline void Store(LogRecord &r, uint8_t i, long v) { r.kinds[i] = LogArgKind::INT; r.args[i].i = v; }
+  inline void Store(LogRecord &r, uint8_t i, long long v) { r.kinds[i] = LogArgKind::INT; r.args[i].i = v; }
+  inline void Store(LogRecord &r, uint8_t i, unsigned v) { r.kinds[i] = LogArgKind::UINT; r.args[i].u = v; }
+  inline void Store(LogRecord &r, uint8_t i, unsigned long v) { r.kinds[i] = LogArgKind::UINT; r.args[i].u = v; }
+  inline void Store(LogRecord &r, uint8_t i, unsigned long long v) { r.kinds[i] = LogArgKind::UINT; r.args[i].u = v; }
+  inline void Store(LogRecord &r, uint8_t i, double v) { r.kinds[i] = LogArgKind::DOUBLE; r.args[i].d = v; }
+  inline void Store(LogRecord &r, uint8_t i, const char *v) { r.kinds[i] = LogArgKind::STR; r.args[i].s = v; }
+
+  inline void StoreArgs(LogRecord &, uint8_t) {}
+
+  template <typename A, typename... Rest>
+  inline void StoreArgs(LogRecord &r, uint8_t i, A a, Rest... rest)
+  {
+    Store(r, i, a);
+    StoreArgs(r, i + 1, rest...);
+  }
+} // namespace logdetail
+
+template <typename... Args>
+inline void LogDeferred(bool newline, const char *fmt, Args... args)
+{
+  static_assert(sizeof...(Args) <= LOG_MAX_ARGS, "too many arguments for a deferred log record");
+  const size_t p = logdetail::ProducerIndex();
+  LogRecord *r = logRings[p].Claim();
+  if (!r)
+  {
+    logDropped[p].store(logDropped[p].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    return;
+  }
+  r->fmt = fmt;
+  r->timestampMs = hal::Millis();
+  r->argc = sizeof...(Args);
+  r->newline = newline;
+  logdetail::StoreArgs(*r, 0, args...);
+  logRings[p].Publish();
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+// Thin hardware abstraction layer for the processor: PWM sink, GPIO source and monotonic clock.
+// On Arduino targets everything is inline and compiles down to the framework calls; the PWM sink is
+// the compile-time backend policy in pwm_backend.h.
+// The native build (no ARDUINO define) links against the simulated backend in src/sim/hal_sim.cpp,
+// which runs on a virtual clock that the host advances explicitly.
+
+#include <stdint.h>
+#include <stddef.h>
+
+#if defined(ARDUINO)
+  #include <Arduino.h>
+#else
+  #include <cmath>
+  #include <cstdio>
+#endif
+
+// Interrupt callbacks (PWM fade completion, GPIO edges) must live in IRAM on the ESP chips
+#if defined(ARDUINO) && (defined(ESP32) || defined(ESP8266))
+  #define HAL_ISR_ATTR IRAM_ATTR
+#else
+  #define HAL_ISR_ATTR
+#endif
+
+namespace hal
+{
+  typedef void (*GpioIsr)(void *arg);
+
+#if defined(ARDUINO)
+  // ---------- Monotonic clock ----------
+  inline uint32_t Millis() { return millis(); }
+  inline uint32_t Micros() { return micros(); }
+  #if defined(ESP32) || defined(ESP8266)
+    // CPU cycle counter (per core on ESP32; wraps, so only differences are meaningful)
+    inline uint32_t CycleCount() { return ESP.getCycleCount(); }
+    inline uint32_t CpuMhz() { return ESP.getCpuFreqMHz(); }
+  #else
+    inline uint32_t CycleCount() { return micros(); }
+    inline uint32_t CpuMhz() { return 1; }
+  #endif
+
+  // ---------- GPIO source ----------
+  inline void GpioInputPullup(int pin) { pinMode(pin, INPUT_PULLUP); }
+  inline bool GpioRead(int pin) { return digitalRead(pin) != LOW; }
+  // isr(arg) runs on both edges; it must be HAL_ISR_ATTR
+  inline void GpioAttachChangeInterrupt(int pin, GpioIsr isr, void *arg)
+  {
+    attachInterruptArg(digitalPinToInterrupt(pin), isr, arg, CHANGE);
+  }
+#else
+  uint32_t Millis();
+  uint32_t Micros();
+  uint32_t CycleCount(); // host cycle/tick counter (real time, not the virtual clock)
+  uint32_t CpuMhz();     // its rate, calibrated on first use
+  void PwmAttach(int pin, int hz, int bits); // wrapped by SimPwm in pwm_backend.h
+  void PwmWrite(int pin, uint32_t duty);
+  // Emulated peripheral fade: linear from -> to over ms; done() runs once it completes
+  bool PwmFade(int pin, uint32_t from, uint32_t to, uint32_t ms, void (*done)());
+  void PwmFadeStop(int pin);
+  void GpioInputPullup(int pin);
+  bool GpioRead(int pin);
+  void GpioAttachChangeInterrupt(int pin, GpioIsr isr, void *arg); // fired by sim::SetPin()
+
+  // Native log sink for LogDrain() (stdout, can be muted by the simulator)
+  void NativeLogLine(const char *line, bool newline, uint32_t timestampMs);
+#endif
+} // namespace hal
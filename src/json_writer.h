@@ -0,0 +1,247 @@
+#pragma once
+
+// Streaming JSON writer into a caller-provided fixed buffer: no heap, no String temporaries, one
+// pass per value (strings are escaped as they are copied, unescaped runs in one memcpy). Commas are inserted automatically.
+// Once a write does not fit the writer stops and Ok() turns false; the buffer always stays
+// NUL-terminated. Save()/Rewind() drop a partially written value, e.g. to end a batch frame early.
+//
+//   char buf[128];
+//   JsonWriter w(buf, sizeof(buf));
+//   w.BeginObject().Field("type", "log").Key("timestamp").Uint(ts).EndObject();
+//   if (w.Ok()) send(w.Data(), w.Length());
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+class JsonWriter
+{
+public:
+  static constexpr uint8_t MAX_DEPTH = 16;
+
+  struct Mark
+  {
+    size_t len;
+    uint8_t depth;
+    uint16_t first;
+  };
+
+  // cap includes the terminating NUL and must be at least 1
+  JsonWriter(char *buf, size_t cap) : buf_(buf), cap_(cap - 1) { buf_[0] = '\0'; }
+
+  JsonWriter &BeginObject() { return Open('{'); }
+  JsonWriter &EndObject() { return Close('}'); }
+  JsonWriter &BeginArray() { return Open('['); }
+  JsonWriter &EndArray() { return Close(']'); }
+
+  // Object key; keys are plain identifiers and are not escaped
+  JsonWriter &Key(const char *key)
+  {
+    Separator();
+    Put('"');
+    PutRaw(key, strlen(key));
+    PutRaw("\":", 2);
+    afterKey_ = true;
+    return *this;
+  }
+
+  JsonWriter &String(const char *s) { return String(s, strlen(s)); }
+  JsonWriter &String(const char *s, size_t len)
+  {
+    Separator();
+    Put('"');
+    size_t run = 0; // start of the pending run of characters that need no escaping
+    for (size_t i = 0; i < len; ++i)
+    {
+      const unsigned char c = (unsigned char)s[i];
+      if (c >= 0x20 && c != '"' && c != '\\')
+        continue;
+      PutRaw(s + run, i - run);
+      run = i + 1;
+      switch (c)
+      {
+        case '"':  PutRaw("\\\"", 2); break;
+        case '\\': PutRaw("\\\\", 2); break;
+        case '\n': PutRaw("\\n", 2); break;
+        case '\r': PutRaw("\\r", 2); break;
+        case '\t': PutRaw("\\t", 2); break;
+        default:
+        {
+          static const char HEX[] = "0123456789abcdef";
+          const char esc[6] = {'\\', 'u', '0', '0', HEX[c >> 4], HEX[c & 0xF]};
+          PutRaw(esc, sizeof(esc));
+          break;
+        }
+      }
+    }
+    PutRaw(s + run, len - run);
+    Put('"');
+    return *this;
+  }
+
+  JsonWriter &Uint(uint64_t v)
+  {
+    Separator();
+    PutDigits(v);
+    return *this;
+  }
+
+  JsonWriter &Int(int64_t v)
+  {
+    Separator();
+    if (v < 0)
+      Put('-');
+    PutDigits(v < 0 ? (uint64_t)0 - (uint64_t)v : (uint64_t)v);
+    return *this;
+  }
+
+  // Fixed-point number: Fixed(655, 1) writes 65.5 (no floating point, no printf)
+  JsonWriter &Fixed(int64_t scaled, uint8_t decimals)
+  {
+    Separator();
+    if (decimals > 18)
+      decimals = 18;
+    uint64_t v = scaled < 0 ? (uint64_t)0 - (uint64_t)scaled : (uint64_t)scaled;
+    if (scaled < 0)
+      Put('-');
+    uint64_t div = 1;
+    for (uint8_t i = 0; i < decimals; ++i)
+      div *= 10;
+    PutDigits(v / div);
+    if (decimals == 0)
+      return *this;
+    Put('.');
+    char frac[19];
+    uint64_t f = v % div;
+    for (uint8_t i = decimals; i > 0; --i)
+    {
+      frac[i - 1] = (char)('0' + f % 10);
+      f /= 10;
+    }
+    PutRaw(frac, decimals);
+    return *this;
+  }
+
+  JsonWriter &Bool(bool v)
+  {
+    Separator();
+    if (v)
+      PutRaw("true", 4);
+    else
+      PutRaw("false", 5);
+    return *this;
+  }
+
+  // Pre-serialized JSON value (e.g. a nested document built elsewhere)
+  JsonWriter &Raw(const char *json, size_t len)
+  {
+    Separator();
+    PutRaw(json, len);
+    return *this;
+  }
+
+  // Key + string value
+  JsonWriter &Field(const char *key, const char *v) { return Key(key).String(v); }
+
+  Mark Save() const { return Mark{len_, depth_, first_}; }
+  void Rewind(const Mark &m)
+  {
+    len_ = m.len;
+    depth_ = m.depth;
+    first_ = m.first;
+    afterKey_ = false;
+    ok_ = true;
+    buf_[len_] = '\0';
+  }
+
+  bool Ok() const { return ok_; }
+  const char *Data() const { return buf_; }
+  size_t Length() const { return len_; }
+  size_t Capacity() const { return cap_; }
+
+private:
+  JsonWriter &Open(char c)
+  {
+    Separator();
+    Put(c);
+    if (depth_ < MAX_DEPTH)
+    {
+      ++depth_;
+      first_ |= (uint16_t)(1u << (depth_ - 1));
+    }
+    else
+    {
+      ok_ = false;
+    }
+    return *this;
+  }
+
+  JsonWriter &Close(char c)
+  {
+    if (depth_ > 0)
+      --depth_;
+    afterKey_ = false;
+    Put(c);
+    return *this;
+  }
+
+  // Comma before every value except the first in its container, and never right after a key
+  void Separator()
+  {
+    if (afterKey_)
+    {
+      afterKey_ = false;
+      return;
+    }
+    if (depth_ == 0)
+      return;
+    const uint16_t bit = (uint16_t)(1u << (depth_ - 1));
+    if (first_ & bit)
+      first_ &= (uint16_t)~bit;
+    else
+      Put(',');
+  }
+
+  void PutDigits(uint64_t v)
+  {
+    char tmp[20];
+    size_t n = sizeof(tmp);
+    do
+    {
+      tmp[--n] = (char)('0' + v % 10);
+      v /= 10;
+    } while (v);
+    PutRaw(tmp + n, sizeof(tmp) - n);
+  }
+
+  void Put(char c)
+  {
+    if (!ok_ || len_ >= cap_)
+    {
+      ok_ = false;
+      return;
+    }
+    buf_[len_++] = c;
+    buf_[len_] = '\0';
+  }
+
+  void PutRaw(const char *s, size_t n)
+  {
+    if (!ok_ || n > cap_ - len_)
+    {
+      ok_ = false;
+      return;
+    }
+    memcpy(buf_ + len_, s, n);
+    len_ += n;
+    buf_[len_] = '\0';
+  }
+
+  char *buf_;
+  size_t cap_;
+  size_t len_ = 0;
+  uint16_t first_ = 0; // bit d-1 set: container at depth d has no value yet
+  uint8_t depth_ = 0;
+  bool afterKey_ = false;
+  bool ok_ = true;
+};
@@ -0,0 +1,137 @@
+#pragma once
+
+// Fixed-size byte arena of variable-length log records for the dashboard replay buffer.
+// Each record is [uint16 length][uint32 timestamp][message bytes], stored contiguously; when a
+// record does not fit before the end of the buffer, writing wraps to the start and the oldest
+// records are evicted until there is room. No heap allocation ever happens after construction.
+// Records are numbered in append order, so readers can keep a cursor (a sequence number) into the
+// shared history instead of a copy of their own, and tell how many lines were evicted under them.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+template <size_t Bytes>
+class LogArena
+{
+public:
+  static constexpr size_t HEADER_BYTES = sizeof(uint16_t) + sizeof(uint32_t);
+  static constexpr size_t MAX_MESSAGE = Bytes / 4 - HEADER_BYTES; // keep at least ~4 lines resident
+  static_assert(Bytes >= 64 && Bytes <= 65535, "LogArena size must be 64..65535 bytes");
+
+  // Append one line; longer messages are truncated to MAX_MESSAGE bytes. Returns its sequence number.
+  uint32_t Append(uint32_t timestamp, const char *msg, size_t len)
+  {
+    if (len > MAX_MESSAGE)
+      len = MAX_MESSAGE;
+    const size_t need = HEADER_BYTES + len;
+
+    for (;;)
+    {
+      if (count_ == 0)
+      {
+        head_ = tail_ = end_ = 0;
+        wrapped_ = false;
+      }
+      if (!wrapped_)
+      {
+        // Data lives in [tail, head); room is whatever is left before the end of the buffer
+        if (Bytes - head_ >= need)
+          break;
+        end_ = head_;
+        head_ = 0;
+        wrapped_ = true;
+        continue;
+      }
+      // Data lives in [tail, end) + [0, head); room is the gap in between
+      if (tail_ - head_ >= need)
+        break;
+      EvictOldest();
+    }
+
+    const uint16_t len16 = (uint16_t)len;
+    memcpy(buf_ + head_, &len16, sizeof(len16));
+    memcpy(buf_ + head_ + sizeof(len16), &timestamp, sizeof(timestamp));
+    memcpy(buf_ + head_ + HEADER_BYTES, msg, len);
+    head_ += need;
+    used_ += need;
+    ++count_;
+    return nextSeq_++;
+  }
+
+  // Visit records oldest first: fn(uint32_t timestamp, const char *msg, size_t len).
+  // Messages are not NUL-terminated.
+  template <typename Fn>
+  void ForEach(Fn fn) const
+  {
+    Walk(FirstSeq(), [&](uint32_t, uint32_t timestamp, const char *msg, size_t len)
+    {
+      fn(timestamp, msg, len);
+      return true;
+    });
+  }
+
+  // Visit records from sequence number seq on (or from the oldest resident one if seq was already
+  // evicted): fn(uint32_t seq, uint32_t timestamp, const char *msg, size_t len) returns false to stop
+  template <typename Fn>
+  void ForEachFrom(uint32_t seq, Fn fn) const
+  {
+    Walk(seq, fn);
+  }
+
+  // Sequence numbers of the oldest resident record and of the next one to be appended; equal when
+  // empty. They wrap after 2^32 records, so compare them by difference.
+  uint32_t FirstSeq() const { return nextSeq_ - (uint32_t)count_; }
+  uint32_t NextSeq() const { return nextSeq_; }
+
+  size_t Count() const { return count_; }
+  size_t UsedBytes() const { return used_; }
+  static constexpr size_t CapacityBytes() { return Bytes; }
+
+private:
+  template <typename Fn>
+  void Walk(uint32_t fromSeq, Fn fn) const
+  {
+    const uint32_t first = FirstSeq();
+    const uint32_t skip = (int32_t)(fromSeq - first) > 0 ? fromSeq - first : 0;
+    size_t pos = tail_;
+    for (size_t i = 0; i < count_; ++i)
+    {
+      if (wrapped_ && pos == end_)
+        pos = 0;
+      uint16_t len;
+      memcpy(&len, buf_ + pos, sizeof(len));
+      if (i >= skip)
+      {
+        uint32_t timestamp;
+        memcpy(&timestamp, buf_ + pos + sizeof(len), sizeof(timestamp));
+        if (!fn(first + (uint32_t)i, timestamp, (const char *)(buf_ + pos + HEADER_BYTES), (size_t)len))
+          return;
+      }
+      pos += HEADER_BYTES + len;
+    }
+  }
+
+  void EvictOldest()
+  {
+    uint16_t len;
+    memcpy(&len, buf_ + tail_, sizeof(len));
+    tail_ += HEADER_BYTES + len;
+    used_ -= HEADER_BYTES + len;
+    --count_;
+    if (tail_ == end_)
+    {
+      tail_ = 0;
+      wrapped_ = false;
+    }
+  }
+
+  uint8_t buf_[Bytes];
+  size_t head_ = 0;  // next write offset
+  size_t tail_ = 0;  // oldest record offset
+  size_t end_ = 0;   // end of valid data before the wrap point (only meaningful when wrapped)
+  size_t used_ = 0;
+  size_t count_ = 0;
+  uint32_t nextSeq_ = 0;
+  bool wrapped_ = false;
+};
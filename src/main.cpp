@@ -1,31 +1,69 @@
 #include <Arduino.h>
 #include "platform_config.h"
+#include "boot_profile.h"
+#include "metrics.h"
 #include "processor.h"
+#include "processor_task.h"
 #include "ota_server.h"
 
+static bool serviceInLoop = true; // false once the processor task owns ServiceProcessor()
+
 void setup()
 {
-  // Initialize serial communication
-  setupSerial(true, 115200, 1500);
+  BootMark("setup");
+
+  // Initialize serial communication; no waiting for a host, early LOGFLN records stay queued
+  setupSerial(false, 115200);
+  BootMark("serial");
 
   // Get platform-specific configuration and initialize processor
   ProcessorConfig cfg = getPlatformConfig();
   InitializeProcessor(cfg);
+  BootMark("processor");
+  #if PROCESSOR_TASK
+    serviceInLoop = !StartProcessorTask(); // fall back to loop() if the task can't be created
+    BootMark("processor_task");
+  #endif
+  BootMark("ready"); // motor and button live
 
-// Setup OTA server
+// Start WiFi without waiting; serviceOTA() brings up the OTA server once the link is up
 #if ENABLE_OTA
   setupWiFi();
-  setupOTA();
+  BootMark("wifi_begin");
 #endif
+  BootPrintTimeline(); // WiFi/OTA stages arrive later: `boot` or /api/boot for the full timeline
 }
 
 void loop()
 {
-  HandleSerialCLI();  // USB CLI (noop if nothing connected)
-  ServiceProcessor(); // buttons, timed stop, phase machine
+  static bool firstPass = true;
+  if (firstPass)
+    BootMark("first_loop");
+  #if ENABLE_METRICS
+    static uint32_t lastPassCycles = 0;
+    const uint32_t passCycles = hal::CycleCount();
+    if (!firstPass)
+      MetricsRecord(MetricProbe::LOOP, passCycles - lastPassCycles); // start-to-start, WiFi/yield included
+    lastPassCycles = passCycles;
+  #endif
+  firstPass = false;
+
+  {
+    METRICS_SCOPE(MetricProbe::SERIAL_CLI);
+    HandleSerialCLI();  // USB CLI (noop if nothing connected)
+  }
+  if (serviceInLoop)
+  {
+    ServiceProcessor(); // buttons, timed stop, phase machine (the processor task does this on ESP32)
+  }
 
-  // Service OTA functionality
+  // WiFi connect/reconnect and OTA functionality
   #if ENABLE_OTA
+  {
+    METRICS_SCOPE(MetricProbe::SERVICE_OTA);
     serviceOTA();
+  }
   #endif
+
+  LogDrain(); // format & fan out queued LOGF/LOGFLN records in idle time
 }
@@ -0,0 +1,226 @@
+#include "metrics.h"
+#include "processor.h"
+#include "json_writer.h"
+#include <stdio.h>
+#include <string.h>
+
+namespace
+{
+  // Single writer per probe: plain load/store pairs, no read-modify-write instructions needed
+  struct ProbeStats
+  {
+    std::atomic<uint32_t> count{0};
+    std::atomic<uint32_t> maxCycles{0};
+    std::atomic<uint32_t> sumLo{0}; // 64-bit sum split so readers can detect a carry in between
+    std::atomic<uint32_t> sumHi{0};
+    std::atomic<uint32_t> buckets[METRIC_BUCKETS];
+  };
+  ProbeStats probes[METRIC_PROBES];
+  std::atomic<uint32_t> counters[METRIC_COUNTERS];
+
+  const char *const PROBE_NAMES[METRIC_PROBES] = {"loop", "service_processor", "serial_cli", "service_ota"};
+
+  // Exported alongside the probes; values gathered by Snapshot()
+  struct ExportedCounter
+  {
+    const char *name;
+    const char *type;
+  };
+  const ExportedCounter EXPORTED[] = {
+      {"phase_transitions_total", "counter"},
+      {"pwm_writes_total", "counter"},
+      {"commands_executed_total", "counter"},
+      {"commands_rejected_total", "counter"},
+      {"ws_frames_sent_total", "counter"},
+      {"ws_frames_dropped_total", "counter"},
+      {"log_records_dropped_total", "counter"},
+      {"ws_clients_throttled_total", "counter"},
+      {"ws_log_lines_dropped_total", "counter"},
+      {"ws_clients_disconnected_total", "counter"},
+      {"cpu_mhz", "gauge"},
+  };
+  constexpr size_t EXPORTED_COUNT = sizeof(EXPORTED) / sizeof(EXPORTED[0]);
+
+  void Snapshot(uint32_t *out)
+  {
+    const ProcessorSchedulerStats sched = ProcessorGetSchedulerStats();
+    const ProcessorCommandStats cmd = ProcessorGetCommandStats();
+    out[0] = sched.transitions;
+    out[1] = ProcessorGetPwmWrites();
+    out[2] = cmd.executed;
+    out[3] = cmd.rejected;
+    out[4] = MetricsGetCounter(MetricCounter::WS_FRAMES_SENT);
+    out[5] = MetricsGetCounter(MetricCounter::WS_FRAMES_DROPPED);
+    out[6] = LogGetStats().dropped;
+    out[7] = MetricsGetCounter(MetricCounter::WS_CLIENTS_THROTTLED);
+    out[8] = MetricsGetCounter(MetricCounter::WS_LOG_LINES_DROPPED);
+    out[9] = MetricsGetCounter(MetricCounter::WS_CLIENTS_DISCONNECTED);
+    out[10] = hal::CpuMhz();
+  }
+
+  inline void Store(std::atomic<uint32_t> &a, uint32_t v) { a.store(v, std::memory_order_relaxed); }
+  inline uint32_t Load(const std::atomic<uint32_t> &a) { return a.load(std::memory_order_relaxed); }
+
+  inline size_t BucketOf(uint32_t cycles)
+  {
+    // ceil(log2(cycles)) - 8, clamped: bucket b holds samples <= 2^(b + 8)
+    const uint32_t v = cycles > 1 ? cycles - 1 : 1;
+    const int ceilLog2 = 32 - __builtin_clz(v);
+    if (ceilLog2 <= 8)
+      return 0;
+    const size_t b = (size_t)(ceilLog2 - 8);
+    return b < METRIC_BUCKETS ? b : METRIC_BUCKETS - 1;
+  }
+} // namespace
+
+void MetricsRecord(MetricProbe probe, uint32_t cycles)
+{
+  ProbeStats &p = probes[(size_t)probe];
+  Store(p.count, Load(p.count) + 1);
+  if (cycles > Load(p.maxCycles))
+    Store(p.maxCycles, cycles);
+  const uint32_t lo = Load(p.sumLo) + cycles;
+  if (lo < cycles)
+    Store(p.sumHi, Load(p.sumHi) + 1);
+  Store(p.sumLo, lo);
+  std::atomic<uint32_t> &bucket = p.buckets[BucketOf(cycles)];
+  Store(bucket, Load(bucket) + 1);
+}
+
+void MetricsAdd(MetricCounter counter, uint32_t n)
+{
+  std::atomic<uint32_t> &c = counters[(size_t)counter];
+  Store(c, Load(c) + n);
+}
+
+MetricProbeSnapshot MetricsGetProbe(MetricProbe probe)
+{
+  const ProbeStats &p = probes[(size_t)probe];
+  MetricProbeSnapshot s;
+  s.count = Load(p.count);
+  s.maxCycles = Load(p.maxCycles);
+  uint32_t hi, lo;
+  do
+  {
+    hi = Load(p.sumHi);
+    lo = Load(p.sumLo);
+  } while (hi != Load(p.sumHi));
+  s.sumCycles = ((uint64_t)hi << 32) | lo;
+  for (size_t b = 0; b < METRIC_BUCKETS; ++b)
+    s.buckets[b] = Load(p.buckets[b]);
+  return s;
+}
+
+uint32_t MetricsGetCounter(MetricCounter counter)
+{
+  return Load(counters[(size_t)counter]);
+}
+
+const char *MetricProbeName(MetricProbe probe)
+{
+  return PROBE_NAMES[(size_t)probe];
+}
+
+MetricsPrometheusWriter::MetricsPrometheusWriter()
+{
+  static_assert(EXPORTED_COUNTERS == EXPORTED_COUNT, "exported counter table out of sync");
+  for (size_t i = 0; i < METRIC_PROBES; ++i)
+  {
+    MetricProbeSnapshot &s = probes_[i];
+    s = MetricsGetProbe((MetricProbe)i);
+    // Cumulative buckets; count follows them so the family is self-consistent
+    uint32_t total = 0;
+    finiteBuckets_[i] = 0;
+    for (size_t b = 0; b < METRIC_BUCKETS; ++b)
+    {
+      if (s.buckets[b] && b < METRIC_BUCKETS - 1)
+        finiteBuckets_[i] = (uint8_t)(b + 1);
+      total += s.buckets[b];
+      s.buckets[b] = total;
+    }
+    s.count = total;
+  }
+  Snapshot(counters_);
+}
+
+bool MetricsPrometheusWriter::NextLine()
+{
+  int n = -1;
+  while (n < 0)
+  {
+    if (section_ < METRIC_PROBES)
+    {
+      const MetricProbeSnapshot &s = probes_[section_];
+      const char *name = PROBE_NAMES[section_];
+      const size_t finite = finiteBuckets_[section_];
+      const size_t step = step_++;
+      if (step == 0)
+        n = snprintf(line_, sizeof(line_), "# TYPE rotator_%s_cycles histogram\n", name);
+      else if (step <= finite)
+        n = snprintf(line_, sizeof(line_), "rotator_%s_cycles_bucket{le=\"%u\"} %u\n", name,
+                     (unsigned)MetricBucketBound(step - 1), (unsigned)s.buckets[step - 1]);
+      else
+        switch (step - finite)
+        {
+          case 1: n = snprintf(line_, sizeof(line_), "rotator_%s_cycles_bucket{le=\"+Inf\"} %u\n", name, (unsigned)s.count); break;
+          case 2: n = snprintf(line_, sizeof(line_), "rotator_%s_cycles_sum %llu\n", name, (unsigned long long)s.sumCycles); break;
+          case 3: n = snprintf(line_, sizeof(line_), "rotator_%s_cycles_count %u\n", name, (unsigned)s.count); break;
+          case 4: n = snprintf(line_, sizeof(line_), "# TYPE rotator_%s_cycles_max gauge\n", name); break;
+          case 5: n = snprintf(line_, sizeof(line_), "rotator_%s_cycles_max %u\n", name, (unsigned)s.maxCycles); break;
+          default:
+            ++section_;
+            step_ = 0;
+            break;
+        }
+    }
+    else
+    {
+      const size_t i = step_ / 2;
+      if (i >= EXPORTED_COUNT)
+        return false;
+      if (step_++ % 2 == 0)
+        n = snprintf(line_, sizeof(line_), "# TYPE rotator_%s %s\n", EXPORTED[i].name, EXPORTED[i].type);
+      else
+        n = snprintf(line_, sizeof(line_), "rotator_%s %u\n", EXPORTED[i].name, (unsigned)counters_[i]);
+    }
+  }
+  lineLen_ = (size_t)n < sizeof(line_) ? (size_t)n : sizeof(line_) - 1;
+  lineOff_ = 0;
+  return true;
+}
+
+size_t MetricsPrometheusWriter::Fill(char *out, size_t cap)
+{
+  size_t written = 0;
+  while (written < cap)
+  {
+    if (lineOff_ == lineLen_ && !NextLine())
+      break;
+    size_t chunk = lineLen_ - lineOff_;
+    if (chunk > cap - written)
+      chunk = cap - written;
+    memcpy(out + written, line_ + lineOff_, chunk);
+    lineOff_ += chunk;
+    written += chunk;
+  }
+  return written;
+}
+
+size_t MetricsFormatCompact(char *out, size_t cap)
+{
+  uint32_t c[EXPORTED_COUNT];
+  Snapshot(c);
+  JsonWriter w(out, cap);
+  w.BeginObject().Field("type", "metrics").Key("mhz").Uint(c[EXPORTED_COUNT - 1]);
+  for (size_t i = 0; i < METRIC_PROBES; ++i)
+  {
+    const MetricProbeSnapshot s = MetricsGetProbe((MetricProbe)i);
+    w.Key(PROBE_NAMES[i]).BeginArray().Uint(s.count).Uint(s.count ? s.sumCycles / s.count : 0).Uint(s.maxCycles).EndArray();
+  }
+  static const char *const KEYS[] = {"phase", "pwm", "cmd", "cmd_rej", "ws_tx", "ws_drop", "log_drop",
+                                      "ws_throttle", "ws_log_drop", "ws_kick"};
+  for (size_t i = 0; i < sizeof(KEYS) / sizeof(KEYS[0]); ++i)
+    w.Key(KEYS[i]).Uint(c[i]);
+  w.EndObject();
+  return w.Ok() ? w.Length() : 0; // 0: buffer too small
+}
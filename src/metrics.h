@@ -0,0 +1,94 @@
+#pragma once
+
+// Low-overhead performance metrics: cycle-counter timing of the hot paths into log2-bucketed
+// histograms, plus event counters. Recording costs two cycle-counter reads and a few relaxed
+// stores (no locks, no allocation), so it stays on in production; -D ENABLE_METRICS=0 removes the
+// timing scopes. Exposed as Prometheus text at /api/metrics and as a compact "metrics" WebSocket
+// message next to the periodic status broadcast.
+
+#include "hal.h"
+#include <atomic>
+
+#ifndef ENABLE_METRICS
+  #define ENABLE_METRICS 1
+#endif
+
+enum class MetricProbe : uint8_t {
+  LOOP,              // loop() start-to-start period (includes WiFi/yield time between passes)
+  SERVICE_PROCESSOR, // one ServiceProcessor() call
+  SERIAL_CLI,        // one HandleSerialCLI() call
+  SERVICE_OTA        // one serviceOTA() call
+};
+constexpr size_t METRIC_PROBES = 4;
+
+enum class MetricCounter : uint8_t {
+  WS_FRAMES_SENT,         // per client
+  WS_FRAMES_DROPPED,      // per client, send queue full (once per stall, see ws_outbox.h)
+  WS_CLIENTS_THROTTLED,   // a client's byte budget ran out
+  WS_LOG_LINES_DROPPED,   // per client, evicted from the history before it got them
+  WS_CLIENTS_DISCONNECTED // saturated too long
+};
+constexpr size_t METRIC_COUNTERS = 5;
+
+// Bucket b < METRIC_BUCKETS - 1 counts samples <= 2^(b + 8) cycles; the last one is overflow
+constexpr size_t METRIC_BUCKETS = 24;
+constexpr uint32_t MetricBucketBound(size_t b) { return 1u << (b + 8); }
+
+// Each probe and counter has a single writer (SERVICE_PROCESSOR: whichever thread services the
+// processor; everything else: loop()). Readers on other threads get relaxed, best-effort values.
+void MetricsRecord(MetricProbe probe, uint32_t cycles);
+void MetricsAdd(MetricCounter counter, uint32_t n = 1);
+
+// Times the enclosing scope into a probe
+class MetricsScope
+{
+public:
+  explicit MetricsScope(MetricProbe probe) : probe_(probe), start_(hal::CycleCount()) {}
+  ~MetricsScope() { MetricsRecord(probe_, hal::CycleCount() - start_); }
+
+private:
+  MetricProbe probe_;
+  uint32_t start_;
+};
+
+#if ENABLE_METRICS
+  #define METRICS_SCOPE(probe) MetricsScope metricsScope_(probe)
+#else
+  #define METRICS_SCOPE(probe) do { } while (0)
+#endif
+
+struct MetricProbeSnapshot {
+  uint32_t count     = 0;
+  uint32_t maxCycles = 0;
+  uint64_t sumCycles = 0;
+  uint32_t buckets[METRIC_BUCKETS] = {};
+};
+MetricProbeSnapshot MetricsGetProbe(MetricProbe probe);
+uint32_t MetricsGetCounter(MetricCounter counter);
+const char *MetricProbeName(MetricProbe probe);
+
+// Prometheus text exposition, produced a piece at a time into caller buffers (e.g. a chunked HTTP
+// response) so the page is never held in RAM as a whole. Values are snapshotted on construction.
+class MetricsPrometheusWriter
+{
+public:
+  MetricsPrometheusWriter();
+  size_t Fill(char *out, size_t cap); // bytes written; 0 once everything has been written
+
+private:
+  bool NextLine();
+
+  static constexpr size_t EXPORTED_COUNTERS = 11;
+
+  MetricProbeSnapshot probes_[METRIC_PROBES]; // buckets made cumulative
+  uint8_t finiteBuckets_[METRIC_PROBES];      // buckets up to the last non-empty one
+  uint32_t counters_[EXPORTED_COUNTERS];
+  char line_[128];
+  size_t lineLen_ = 0;
+  size_t lineOff_ = 0;
+  uint8_t section_ = 0; // probe index, then the counters section
+  uint8_t step_ = 0;    // position inside the section
+};
+
+// {"type":"metrics","mhz":160,"loop":[count,meanCycles,maxCycles],...,"ws_tx":n,...}
+size_t MetricsFormatCompact(char *out, size_t cap);
@@ -1,6 +1,18 @@
 #include "ota_server.h"
-#include <cstdarg>
+#include "boot_profile.h"
+#include "commands.h"
+#include "processor_task.h"
+#include "metrics.h"
+#include "status_channel.h"
+#include "status_json.h"
+#include "seqlock.h"
+#include "spsc_ring.h"
+#include "telemetry.h"
+#include "trace.h"
+#include "ws_outbox.h"
 #include <cstdio>
+#include <cstring>
+#include <memory>
 
 #if ENABLE_OTA
 
@@ -8,109 +20,169 @@
 AsyncWebServer server(OTA_PORT);
 AsyncWebSocket ws("/ws");
 unsigned long ota_progress_millis = 0;
-unsigned long status_update_millis = 0;
-constexpr size_t LOG_HISTORY_SIZE = 50;
 
-struct LogEntry 
+// Outbox transport (ws_outbox.h): every dashboard frame goes to one client at a time, so a client
+// whose send queue is full never holds up the others
+static AsyncWebSocketClient *wsClient(uint32_t clientId)
 {
-  String message;
-  uint32_t timestamp;
+  AsyncWebSocketClient *client = ws.client(clientId);
+  return client && client->status() == WS_CONNECTED ? client : nullptr;
+}
+
+static bool wsCanSend(uint32_t clientId)
+{
+  AsyncWebSocketClient *client = wsClient(clientId);
+  return client && client->canSend();
+}
+
+static void wsSend(uint32_t clientId, const char *data, size_t len, bool binary)
+{
+  AsyncWebSocketClient *client = wsClient(clientId);
+  if (!client)
+    return;
+  if (binary)
+    client->binary(data, len);
+  else
+    client->text(data, len);
+}
+
+static void wsClose(uint32_t clientId)
+{
+  LOGFLN("WebSocket client %u saturated for %u ms - disconnecting", (unsigned)clientId, (unsigned)WS_CLIENT_SATURATED_MS);
+  if (AsyncWebSocketClient *client = ws.client(clientId))
+    client->close();
+}
+
+// Outbox accounting for /api/status. The outbox belongs to loop(), so loop() copies its stats here
+// every OUTBOX_SNAPSHOT_MS and the handler on the AsyncTCP task reads the copy
+struct OutboxSnapshot
+{
+  OutboxHistoryStats history;
+  OutboxClientStats clients[STATUS_MAX_CLIENTS];
+  uint32_t clientCount;
 };
+static SeqLock<OutboxSnapshot> outboxSnapshot;
+static uint32_t outboxSnapshotMs = 0;
+constexpr uint32_t OUTBOX_SNAPSHOT_MS = 250;
 
-static LogEntry logHistory[LOG_HISTORY_SIZE];
-static size_t logHistoryCount = 0;
-static size_t logHistoryHead = 0;
+static void publishOutboxSnapshot(uint32_t nowMs)
+{
+  static bool published = false;
+  if (published && nowMs - outboxSnapshotMs < OUTBOX_SNAPSHOT_MS)
+    return;
+  published = true;
+  outboxSnapshotMs = nowMs;
+  OutboxSnapshot s;
+  s.history = OutboxGetHistoryStats();
+  s.clientCount = (uint32_t)OutboxGetClientStats(s.clients, STATUS_MAX_CLIENTS, nowMs);
+  outboxSnapshot.Write(s);
+}
 
-static String escapeJson(const String &input)
+// Client membership, subscriptions and history requests arrive on the AsyncTCP task; they are
+// queued here, in order, and applied in loop() where the outbox and the status channel live
+struct ClientEvent
 {
-  String escaped;
-  escaped.reserve(input.length() + 8);
-  for (size_t i = 0; i < input.length(); ++i)
-  {
-    const char c = input[i];
-    switch (c)
-    {
-    case '\\':
-      escaped += "\\\\";
-      break;
-    case '"':
-      escaped += "\\\"";
-      break;
-    case '\n':
-      escaped += "\\n";
-      break;
-    case '\r':
-      escaped += "\\r";
-      break;
-    case '\t':
-      escaped += "\\t";
-      break;
-    default:
-      escaped += c;
-      break;
-    }
-  }
-  return escaped;
+  enum class Op : uint8_t { ADD, REMOVE, SUBSCRIBE, HISTORY, TELEMETRY } op;
+  uint32_t clientId;
+  uint8_t topics;      // SUBSCRIBE
+  bool on;             // SUBSCRIBE; HISTORY: replay everything
+  uint32_t intervalMs; // SUBSCRIBE
+  uint32_t sinceMs;    // HISTORY: replay entries strictly newer than this
+  uint32_t hz;         // TELEMETRY: 0 stops the stream
+};
+static SpscRing<ClientEvent, 16> clientEvents;
+
+static void postClientEvent(const ClientEvent &e)
+{
+  if (!clientEvents.Push(e))
+    Serial.println("WebSocket client event queue full - event dropped");
 }
 
-static String buildLogPayload(const LogEntry &entry)
+void OtaSubscribe(uint32_t clientId, uint8_t topics, bool on, uint32_t intervalMs)
 {
-  String payload = "{\"type\":\"log\",\"timestamp\":";
-  payload += String(entry.timestamp);
-  payload += ",\"message\":\"";
-  payload += escapeJson(entry.message);
-  payload += "\"}";
-  return payload;
+  postClientEvent(ClientEvent{ClientEvent::Op::SUBSCRIBE, clientId, topics, on, intervalMs, 0, 0});
 }
 
-static void storeLogEntry(const String &message, uint32_t timestamp)
+void OtaRequestHistory(uint32_t clientId, uint32_t sinceMs, bool all)
 {
-  logHistory[logHistoryHead].message = message;
-  logHistory[logHistoryHead].timestamp = timestamp;
-  logHistoryHead = (logHistoryHead + 1) % LOG_HISTORY_SIZE;
-  if (logHistoryCount < LOG_HISTORY_SIZE)
-  {
-    ++logHistoryCount;
-  }
+  postClientEvent(ClientEvent{ClientEvent::Op::HISTORY, clientId, 0, all, 0, sinceMs, 0});
 }
 
-static void sendLogHistoryToClient(AsyncWebSocketClient *client)
+void OtaTelemetry(uint32_t clientId, uint32_t hz)
 {
-  if (!client || logHistoryCount == 0)
-    return;
+  postClientEvent(ClientEvent{ClientEvent::Op::TELEMETRY, clientId, 0, false, 0, 0, hz});
+}
+
+// Free heap split into usable blocks: 0 = one contiguous block, 100 = fully fragmented
+static uint32_t heapFragmentationPct()
+{
+  #if defined(ESP8266)
+    return ESP.getHeapFragmentation();
+  #else
+    const uint32_t freeHeap = ESP.getFreeHeap();
+    if (freeHeap == 0)
+      return 0;
+    return 100 - (uint32_t)((uint64_t)ESP.getMaxAllocHeap() * 100 / freeHeap);
+  #endif
+}
 
-  size_t oldestIndex = (logHistoryHead + LOG_HISTORY_SIZE - logHistoryCount) % LOG_HISTORY_SIZE;
-  for (size_t i = 0; i < logHistoryCount; ++i)
+static uint32_t heapMaxBlock()
+{
+  #if defined(ESP8266)
+    return ESP.getMaxFreeBlockSize();
+  #else
+    return ESP.getMaxAllocHeap();
+  #endif
+}
+
+// Members shared by the status channel's SYSTEM frames and /api/status
+static void writeSystemJson(JsonWriter &w)
+{
+  w.Key("uptime").Uint(millis());
+  w.Key("heap").Uint(ESP.getFreeHeap());
+  w.Key("heap_max_block").Uint(heapMaxBlock());
+  w.Key("heap_frag").Uint(heapFragmentationPct());
+  w.Key("wifi_rssi").Int(WiFi.RSSI());
+}
+
+// JSON API bodies are built here; the handlers all run on the AsyncTCP task, one at a time, and
+// the response stream copies the body once, so the buffer is free again on return
+static char httpJson[HTTP_JSON_BYTES];
+
+static void sendJson(AsyncWebServerRequest *request, const JsonWriter &w)
+{
+  if (!w.Ok())
   {
-    const LogEntry &entry = logHistory[(oldestIndex + i) % LOG_HISTORY_SIZE];
-    client->text(buildLogPayload(entry));
+    request->send(500, "text/plain", "response too large");
+    return;
   }
+  AsyncResponseStream *response = request->beginResponseStream("application/json", w.Length());
+  response->write((const uint8_t *)w.Data(), w.Length());
+  request->send(response);
 }
 
-void OtaLogLinef(const char *fmt, ...)
+// Called by LogDrain() from loop() with an already formatted LOGFLN line; clients are sent it from
+// the shared history by OutboxPump()
+void OtaLogLine(const char *line, uint32_t timestampMs)
 {
-  char buffer[192];
-  va_list args;
-  va_start(args, fmt);
-  vsnprintf(buffer, sizeof(buffer), fmt, args);
-  va_end(args);
-
-  const uint32_t now = millis();
-  String message(buffer);
-  storeLogEntry(message, now);
+  OutboxLogLine(line, strlen(line), timestampMs);
+}
 
-  if (ws.count() > 0)
+// Network-side commands run on the AsyncTCP task; hand them to ServiceProcessor() via its queue
+static void postCommand(ProcessorCommand cmd, float arg = 0.0f)
+{
+  if (!ProcessorPostCommand(cmd, arg, CommandSource::NETWORK))
   {
-    LogEntry entry{message, now};
-    ws.textAll(buildLogPayload(entry));
+    Serial.println("Processor command queue full - command dropped");
   }
 }
 
 // OTA Progress callbacks
 void onOTAStart()
 {
+  LogBindProducer(LogProducer::NETWORK); // ElegantOTA callbacks run on the AsyncTCP task
   Serial.println("OTA update started!");
-  StopCycleBrake();
+  postCommand(ProcessorCommand::BRAKE_STOP); // loop() keeps running during async uploads
 }
 
 void onOTAProgress(size_t current, size_t final)
@@ -140,74 +212,36 @@ void onOTAEnd(bool success)
 // WebSocket event handler
 void handleWebSocketEvent(AsyncWebSocket *server, AsyncWebSocketClient *client, AwsEventType type, void *arg, uint8_t *data, size_t len)
 {
+  LogBindProducer(LogProducer::NETWORK); // command handlers log from the AsyncTCP task
   switch (type)
   {
     case WS_EVT_CONNECT:
+      // History is replayed on request ("history" / "history_since=<ms>"), so a reconnecting
+      // dashboard only pulls what it missed
       Serial.printf("WebSocket client connected: %u\n", client->id());
-      sendLogHistoryToClient(client);
+      postClientEvent(ClientEvent{ClientEvent::Op::ADD, client->id(), 0, false, 0, 0, 0});
       break;
     case WS_EVT_DISCONNECT:
       Serial.printf("WebSocket client disconnected: %u\n", client->id());
+      postClientEvent(ClientEvent{ClientEvent::Op::REMOVE, client->id(), 0, false, 0, 0, 0});
       break;
     case WS_EVT_DATA:
     {
       AwsFrameInfo *info = (AwsFrameInfo *)arg;
       if (info->final && info->index == 0 && info->len == len && info->opcode == WS_TEXT)
       {
-        String command = "";
-        for (size_t i = 0; i < len; i++)
-        {
-          command += (char)data[i];
-        }
-        
-        Serial.printf("WebSocket command received: %s\n", command.c_str());
+        const char *text = (const char *)data;
+        Serial.printf("WebSocket command received: %.*s\n", (int)len, text);
 
-        // Handle remote commands
-        if (command == "start" || command == "auto_start")
-        {
-          ProcessorCommandAutoStart();
-        }
-        else if (command == "stop" || command == "stop_brake")
-        {
-          ProcessorCommandBrakeStop();
-        }
-        else if (command == "coast" || command == "stop_coast")
-        {
-          ProcessorCommandCoastStop();
-        }
-        else if (command == "manual_fwd")
-        {
-          ProcessorCommandManualForward();
-        }
-        else if (command == "manual_rev")
-        {
-          ProcessorCommandManualReverse();
-        }
-        else if (command == "print_status" || command == "status")
-        {
-          ProcessorCommandPrintState();
-        }
-        else if (command == "test_in1")
-        {
-          ProcessorCommandTestIn1();
-        }
-        else if (command == "test_in2")
-        {
-          ProcessorCommandTestIn2();
-        }
-        else if (command == "motors_off")
-        {
-          ProcessorCommandAllOff();
-        }
-        else if (command.startsWith("set_cruise="))
+        // Parsed in place from the frame buffer against the shared command table (commands.cpp)
+        const CommandResult result = DispatchCommand(text, len, CommandContext{CommandSource::NETWORK, client->id()});
+        if (result == CommandResult::UNKNOWN)
         {
-          const String value = command.substring(String("set_cruise=").length());
-          float pct = value.toFloat();
-          ProcessorCommandSetCruise(pct);
+          Serial.printf("Unknown WebSocket command: %.*s\n", (int)len, text);
         }
-        else
+        else if (result != CommandResult::OK)
         {
-          Serial.printf("Unknown WebSocket command: %s\n", command.c_str());
+          Serial.printf("Bad argument for WebSocket command: %.*s\n", (int)len, text);
         }
       }
       break;
@@ -217,72 +251,247 @@ void handleWebSocketEvent(AsyncWebSocket *server, AsyncWebSocketClient *client,
     }
 }
 
-// Broadcast status updates to all connected WebSocket clients
-void broadcastStatus()
+// WiFi bring-up runs as a state machine from serviceOTA(): nothing here ever waits on the radio, so
+// the processor and buttons are live from reset whether or not the access point is reachable.
+// Link events only set flags (they arrive on the WiFi/event task); transitions happen in loop().
+enum class WiFiState : uint8_t
 {
-  if (ws.count() > 0)
-  {
-    String status = "{\"type\":\"status\",";
-    status += "\"uptime\":" + String(millis()) + ",";
-    status += "\"heap\":" + String(ESP.getFreeHeap()) + ",";
-    status += "\"wifi_rssi\":" + String(WiFi.RSSI());
-    status += "}";
-    ws.textAll(status);
-  }
-}
+  OFF,        // setupWiFi() not called yet
+  CONNECTING, // WiFi.begin() issued, waiting for an IP or the attempt timeout
+  UP,
+  BACKOFF     // attempt failed or link lost; retry at retryAtMs
+};
 
-void setupWiFi()
+static WiFiState wifiState = WiFiState::OFF;
+static std::atomic<bool> wifiLinkUp{false}; // set on got-IP, cleared on disconnect / lost IP
+static uint32_t wifiStateSinceMs = 0;
+static uint32_t wifiRetryAtMs = 0;
+static uint32_t wifiBackoffMs = WIFI_RETRY_MIN_MS;
+static uint32_t wifiReconnects = 0;
+static bool otaStarted = false;
+
+#if defined(ESP8266)
+static WiFiEventHandler wifiGotIpHandler; // handlers stay registered only while referenced
+static WiFiEventHandler wifiDisconnectHandler;
+#else
+static void onWiFiEvent(WiFiEvent_t event, WiFiEventInfo_t info)
 {
-  Serial.printf("Connecting to WiFi network: %s", WIFI_SSID);
+  (void)info;
+  wifiLinkUp.store(event == ARDUINO_EVENT_WIFI_STA_GOT_IP, std::memory_order_release);
+}
+#endif
 
-  WiFi.mode(WIFI_STA);
+static void wifiBegin()
+{
   WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
+  wifiState = WiFiState::CONNECTING;
+  wifiStateSinceMs = millis();
+}
 
-  unsigned long startTime = millis();
-  while (WiFi.status() != WL_CONNECTED && (millis() - startTime) < WIFI_TIMEOUT_MS)
-  {
-    delay(500);
-    Serial.print(".");
-  }
+static void wifiScheduleRetry(uint32_t now)
+{
+  WiFi.disconnect();
+  wifiState = WiFiState::BACKOFF;
+  wifiStateSinceMs = now;
+  wifiRetryAtMs = now + wifiBackoffMs;
+  LOGFLN("WiFi retry in %u ms", (unsigned)wifiBackoffMs);
+  wifiBackoffMs = wifiBackoffMs >= WIFI_RETRY_MAX_MS / 2 ? WIFI_RETRY_MAX_MS : wifiBackoffMs * 2;
+}
 
-  if (WiFi.status() == WL_CONNECTED)
+static void serviceWiFi()
+{
+  const uint32_t now = millis();
+  switch (wifiState)
   {
-    Serial.println("");
-    Serial.printf("WiFi connected! IP address: %s\n", WiFi.localIP().toString().c_str());
-    Serial.printf("OTA interface available at: http://%s/update\n", WiFi.localIP().toString().c_str());
-    Serial.printf("Live dashboard available at: http://%s/\n", WiFi.localIP().toString().c_str());
+    case WiFiState::OFF:
+      break;
+
+    case WiFiState::CONNECTING:
+      if (wifiLinkUp.load(std::memory_order_acquire))
+      {
+        const IPAddress ip = WiFi.localIP();
+        wifiState = WiFiState::UP;
+        wifiStateSinceMs = now;
+        wifiBackoffMs = WIFI_RETRY_MIN_MS;
+        BootMark("wifi_up");
+        LOGFLN("WiFi connected: http://%u.%u.%u.%u/ (dashboard), /update (OTA)",
+               (unsigned)ip[0], (unsigned)ip[1], (unsigned)ip[2], (unsigned)ip[3]);
+        if (!otaStarted)
+          setupOTA(); // deferred until there is a link to serve on
+      }
+      else if (now - wifiStateSinceMs >= WIFI_TIMEOUT_MS)
+      {
+        LOGFLN("WiFi connection to %s timed out", WIFI_SSID);
+        wifiScheduleRetry(now);
+      }
+      break;
+
+    case WiFiState::UP:
+      if (!wifiLinkUp.load(std::memory_order_acquire))
+      {
+        LOGFLN("WiFi link lost after %u s", (unsigned)((now - wifiStateSinceMs) / 1000u));
+        ++wifiReconnects;
+        wifiScheduleRetry(now);
+      }
+      break;
+
+    case WiFiState::BACKOFF:
+      if ((int32_t)(now - wifiRetryAtMs) >= 0)
+        wifiBegin();
+      break;
   }
-  else
+}
+
+// Start connecting and return immediately; serviceOTA() takes it from here
+void setupWiFi()
+{
+  if (wifiState != WiFiState::OFF)
+    return;
+  LOGFLN("Connecting to WiFi network: %s", WIFI_SSID);
+  WiFi.mode(WIFI_STA);
+  WiFi.setAutoReconnect(false); // reconnects are paced by the backoff above
+#if defined(ESP8266)
+  wifiGotIpHandler = WiFi.onStationModeGotIP([](const WiFiEventStationModeGotIP &)
+                                             { wifiLinkUp.store(true, std::memory_order_release); });
+  wifiDisconnectHandler = WiFi.onStationModeDisconnected([](const WiFiEventStationModeDisconnected &)
+                                                         { wifiLinkUp.store(false, std::memory_order_release); });
+#else
+  WiFi.onEvent(onWiFiEvent, ARDUINO_EVENT_WIFI_STA_GOT_IP);
+  WiFi.onEvent(onWiFiEvent, ARDUINO_EVENT_WIFI_STA_DISCONNECTED);
+  WiFi.onEvent(onWiFiEvent, ARDUINO_EVENT_WIFI_STA_LOST_IP);
+#endif
+  wifiBegin();
+}
+
+// Dashboard page. With the generated asset (scripts/build_dashboard.py) it goes out pre-gzipped from
+// flash with a content-hash ETag; browsers revalidate (no-cache) and get an empty 304 until the
+// firmware's dashboard changes. Without it, the raw HTML from web_dashboard.h is sent.
+static void serveDashboard(AsyncWebServerRequest *request)
+{
+#if DASHBOARD_GZ_AVAILABLE
+  if (request->hasHeader("If-None-Match") && request->getHeader("If-None-Match")->value().indexOf(DASHBOARD_ETAG) >= 0)
   {
-    Serial.println("");
-    Serial.println("WiFi connection failed - OTA updates unavailable");
+    AsyncWebServerResponse *response = request->beginResponse(304);
+    response->addHeader("ETag", DASHBOARD_ETAG);
+    response->addHeader("Cache-Control", "no-cache");
+    request->send(response);
+    return;
   }
+  AsyncWebServerResponse *response = request->beginResponse_P(200, "text/html", DASHBOARD_GZ, DASHBOARD_GZ_LEN);
+  response->addHeader("Content-Encoding", "gzip");
+  response->addHeader("ETag", DASHBOARD_ETAG);
+  response->addHeader("Cache-Control", "no-cache");
+  request->send(response);
+#else
+  request->send(200, "text/html", getDashboardHTML());
+#endif
 }
 
 void setupOTA()
 {
-  if (WiFi.status() != WL_CONNECTED)
-  {
-    Serial.println("WiFi not connected - skipping OTA setup");
+  if (otaStarted)
     return;
-  }
+  otaStarted = true;
 
   // Live dashboard with real-time updates
-  server.on("/", HTTP_GET, [](AsyncWebServerRequest *request)
-            { request->send(200, "text/html", getDashboardHTML()); });
+  server.on("/", HTTP_GET, serveDashboard);
 
   // JSON API endpoints
   server.on("/api/status", HTTP_GET, [](AsyncWebServerRequest *request)
             {
-    String json = "{";
-    json += "\"uptime\":" + String(millis()) + ",";
-    json += "\"heap\":" + String(ESP.getFreeHeap()) + ",";
-    json += "\"wifi_rssi\":" + String(WiFi.RSSI()) + ",";
-    json += "\"ip\":\"" + WiFi.localIP().toString() + "\"";
-    json += "}";
-    request->send(200, "application/json", json); });
+    JsonWriter w(httpJson, sizeof(httpJson));
+    w.BeginObject();
+    writeSystemJson(w);
+    char ip[16];
+    const IPAddress addr = WiFi.localIP();
+    snprintf(ip, sizeof(ip), "%u.%u.%u.%u", addr[0], addr[1], addr[2], addr[3]);
+    w.Field("ip", ip);
+    w.Key("wifi_reconnects").Uint(wifiReconnects);
+    ProcessorStatus state;
+    uint32_t version;
+    if (ProcessorGetStatus(state, version))
+    {
+      w.Key("state").BeginObject();
+      WriteMotionJson(w, state);
+      WriteConfigJson(w, state);
+      w.EndObject();
+    }
+    WriteProcessorStatusJson(w);
+    const LogStats logStats = LogGetStats();
+    // Outbox stats as of loop()'s last copy (up to OUTBOX_SNAPSHOT_MS old); left out if the read
+    // kept overlapping a copy
+    OutboxSnapshot outbox;
+    uint32_t outboxVersion;
+    const bool haveOutbox = outboxSnapshot.Read(outbox, outboxVersion);
+    w.Key("log").BeginObject();
+    w.Key("capacity").Uint(logStats.capacity);
+    w.Key("high_water").Uint(logStats.highWater);
+    w.Key("dropped").Uint(logStats.dropped);
+    if (haveOutbox)
+    {
+      w.Key("history_bytes").Uint(outbox.history.bytes);
+      w.Key("history_capacity").Uint(outbox.history.capacity);
+      w.Key("history_entries").Uint(outbox.history.entries);
+    }
+    w.EndObject();
+    // Per-client outbound accounting (ws_outbox.h)
+    w.Key("ws").BeginObject();
+    w.Key("disconnected").Uint(MetricsGetCounter(MetricCounter::WS_CLIENTS_DISCONNECTED));
+    w.Key("clients").BeginArray();
+    for (size_t i = 0; haveOutbox && i < outbox.clientCount; ++i)
+    {
+      const OutboxClientStats &c = outbox.clients[i];
+      w.BeginObject();
+      w.Key("id").Uint(c.id);
+      w.Key("frames").Uint(c.framesSent);
+      w.Key("bytes").Uint(c.bytesSent);
+      w.Key("throttled").Uint(c.throttled);
+      w.Key("stalls").Uint(c.stalls);
+      w.Key("log_dropped").Uint(c.logLinesDropped);
+      w.Key("log_backlog").Uint(c.logBacklog);
+      w.Key("saturated_ms").Uint(c.saturatedMs);
+      w.Key("rate").Uint(c.rate);
+      w.EndObject();
+    }
+    w.EndArray().EndObject();
+    const TelemetryStats telemetry = TelemetryGetStats();
+    w.Key("telemetry").BeginObject();
+    w.Key("samples").Uint(telemetry.samples);
+    w.Key("overruns").Uint(telemetry.overruns);
+    w.Key("subscribers").Uint(telemetry.subscribers);
+    w.EndObject();
+    const TraceStats trace = TraceGetStats();
+    w.Key("trace").BeginObject().Key("recorded").Uint(trace.recorded).Key("capacity").Uint(trace.capacity).EndObject();
+    w.EndObject();
+    sendJson(request, w); });
+
+  // Boot timeline (boot_profile.h): stage times in us since reset, for cold-start regressions
+  server.on("/api/boot", HTTP_GET, [](AsyncWebServerRequest *request)
+            {
+    JsonWriter w(httpJson, sizeof(httpJson));
+    WriteBootJson(w);
+    sendJson(request, w); });
+
+  // Prometheus text exposition (metrics.h), streamed in chunks from a snapshot
+  server.on("/api/metrics", HTTP_GET, [](AsyncWebServerRequest *request)
+            {
+    std::shared_ptr<MetricsPrometheusWriter> writer = std::make_shared<MetricsPrometheusWriter>();
+    request->send(request->beginChunkedResponse("text/plain; version=0.0.4",
+                                                [writer](uint8_t *buffer, size_t maxLen, size_t) -> size_t
+                                                { return writer->Fill((char *)buffer, maxLen); })); });
+
+  // Event trace (trace.h) as Chrome Trace Event JSON; open it in Perfetto (ui.perfetto.dev)
+  server.on("/api/trace", HTTP_GET, [](AsyncWebServerRequest *request)
+            {
+    std::shared_ptr<TraceChromeWriter> writer = std::make_shared<TraceChromeWriter>();
+    AsyncWebServerResponse *response = request->beginChunkedResponse("application/json",
+                                                                      [writer](uint8_t *buffer, size_t maxLen, size_t) -> size_t
+                                                                      { return writer->Fill((char *)buffer, maxLen); });
+    response->addHeader("Content-Disposition", "attachment; filename=\"rotator-trace.json\"");
+    request->send(response); });
 
   // WebSocket setup
+  OutboxBegin(OutboxTransport{wsCanSend, wsSend, wsClose});
   ws.onEvent(handleWebSocketEvent);
   server.addHandler(&ws);
 
@@ -293,17 +502,52 @@ void setupOTA()
   ElegantOTA.onEnd(onOTAEnd);
 
   server.begin();
-  Serial.println("Async OTA server started with live dashboard");
+  BootMark("ota_server");
+  LOGFLN("Async OTA server started with live dashboard");
 }
 
 void serviceOTA()
 {
-  // Send status updates every 2 seconds
-  if (millis() - status_update_millis > 2000)
+  serviceWiFi();
+  if (!otaStarted)
+    return;
+
+  // Client events first, then status (first call on each client's budget), telemetry, then logs
+  ClientEvent e;
+  while (clientEvents.Pop(e))
   {
-    status_update_millis = millis();
-    broadcastStatus();
+    switch (e.op)
+    {
+      case ClientEvent::Op::ADD:
+        if (!OutboxAddClient(e.clientId, millis()) || !StatusAddClient(e.clientId, millis()))
+        {
+          Serial.printf("No slot for WebSocket client %u - closing it\n", (unsigned)e.clientId);
+          OutboxRemoveClient(e.clientId);
+          if (AsyncWebSocketClient *client = ws.client(e.clientId))
+            client->close();
+        }
+        break;
+      case ClientEvent::Op::REMOVE:
+        OutboxRemoveClient(e.clientId);
+        StatusRemoveClient(e.clientId);
+        TelemetryRemoveClient(e.clientId);
+        break;
+      case ClientEvent::Op::SUBSCRIBE:
+        StatusSubscribe(e.clientId, e.topics, e.on, e.intervalMs);
+        break;
+      case ClientEvent::Op::HISTORY:
+        OutboxRequestHistory(e.clientId, e.sinceMs, e.on);
+        break;
+      case ClientEvent::Op::TELEMETRY:
+        if (!TelemetrySubscribe(e.clientId, e.hz, millis()))
+          Serial.printf("Telemetry full - client %u gets no stream\n", (unsigned)e.clientId);
+        break;
+    }
   }
+  StatusPublish(millis(), writeSystemJson, OutboxSend);
+  TelemetryPump(millis(), OutboxSendBinary);
+  OutboxPump(millis());
+  publishOutboxSnapshot(millis());
 
   // Clean up WebSocket connections
   ws.cleanupClients();
@@ -313,9 +557,10 @@ void serviceOTA()
 
 #else
 
-void OtaLogLinef(const char *fmt, ...)
+void OtaLogLine(const char *line, uint32_t timestampMs)
 {
-  (void)fmt; // OTA disabled, ignore mirrored logs
+  (void)line; // OTA disabled, ignore mirrored logs
+  (void)timestampMs;
 }
 
 #endif // ENABLE_OTA
\ No newline at end of file
@@ -18,7 +18,11 @@
   #endif
 
   #include <ElegantOTA.h>
-  #include "web_dashboard.h"
+  #if defined(__has_include) && __has_include("web_dashboard_gz.h")
+    #include "web_dashboard_gz.h" // generated pre-build by scripts/build_dashboard.py
+  #else
+    #include "web_dashboard.h"
+  #endif
   #include "processor.h"
 
   // WiFi Configuration
@@ -29,19 +33,30 @@
     #define WIFI_PASSWORD "wifi_password"  // Normally declared via platformio.ini build_flags
   #endif
 #define OTA_PORT            80    // Web server port for OTA updates
-  #define WIFI_TIMEOUT_MS   10000 // WiFi connection timeout
+  #define WIFI_TIMEOUT_MS   10000 // one connection attempt; never blocks, see serviceOTA()
+  #ifndef WIFI_RETRY_MIN_MS
+    #define WIFI_RETRY_MIN_MS 2000  // first retry after a failed attempt or lost link
+  #endif
+  #ifndef WIFI_RETRY_MAX_MS
+    #define WIFI_RETRY_MAX_MS 60000 // backoff doubles up to this
+  #endif
+  #ifndef HTTP_JSON_BYTES
+    #if defined(ESP8266)
+      #define HTTP_JSON_BYTES 1536 // largest JSON API response body (/api/status, /api/boot)
+    #else
+      #define HTTP_JSON_BYTES 2048 // /api/status lists up to STATUS_MAX_CLIENTS WebSocket clients
+    #endif
+  #endif
 
   // Global objects for OTA functionality
   extern AsyncWebServer server;
   extern AsyncWebSocket ws;
   extern unsigned long ota_progress_millis;
-  extern unsigned long status_update_millis;
 
   // Function declarations
-  void setupOTA();
-  void serviceOTA();
-  void setupWiFi();
-  void broadcastStatus();
+  void setupWiFi();  // starts connecting and returns immediately
+  void setupOTA();   // called by serviceOTA() once the link is first up
+  void serviceOTA(); // WiFi state machine, then web/OTA housekeeping; call from loop()
   void handleWebSocketEvent(AsyncWebSocket *server, AsyncWebSocketClient *client, AwsEventType type, 
                  void *arg, uint8_t *data, size_t len);
   void handleOTAStart();
@@ -50,6 +65,7 @@
 
 #else
   // Redefine as no-op functions for platforms when ENABLE_OTA = false. (Though it should be superfluous since we already check it everywhere.)
+  inline void setupWiFi() { }
   inline void setupOTA() {  }
   inline void serviceOTA() { }
 #endif
\ No newline at end of file
@@ -1,6 +1,5 @@
 #pragma once
 
-#include <Arduino.h>
 #include "processor.h"
 
 // Platform detection and configuration
@@ -25,6 +24,7 @@ inline ProcessorConfig getPlatformConfig()
   cfg.t.coastBetweenMs = 60;
   cfg.t.forwardRunMs   = 10000;
   cfg.t.reverseRunMs   = 10000;
+  cfg.t.rampProfile    = RampProfile::LINEAR; // S_CURVE or EXPONENTIAL soften starts for heavy tanks (use with longer ramps)
 
   //---------------------------------------------------------//
   //  Platform-specific pin assignments & PWM configuration  //
@@ -56,11 +56,36 @@ inline ProcessorConfig getPlatformConfig()
     };
     cfg.pwmHz   = 1000;  // ESP8266 PWM frequency
     cfg.pwmBits = 10;    // ESP8266 supports 10-bit PWM (0-1023)
+  #elif !defined(ARDUINO)
+    // Native simulator (src/sim): pin numbers are only labels for the simulated HAL
+    cfg.pins = {
+        1, // motorPWM1
+        2, // motorPWM2
+        3  // toggleButton
+    };
+    cfg.pwmHz   = 20000;
+    cfg.pwmBits = 11;
   #endif
 
   return cfg;
 }
 
+// Human-readable target name for logs and /api/boot
+inline const char *getPlatformName()
+{
+  #if defined(CONFIG_IDF_TARGET_ESP32C6)
+    return "ESP32-C6";
+  #elif defined(ESP32)
+    return "ESP32";
+  #elif defined(ESP8266)
+    return "ESP8266";
+  #elif !defined(ARDUINO)
+    return "native";
+  #else
+    return "Unknown";
+  #endif
+}
+
 // Handle OTA default
 #ifndef ENABLE_OTA
   #define ENABLE_OTA 0
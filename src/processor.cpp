@@ -1,9 +1,21 @@
 #include "processor.h"
+#include "buttons.h"
+#include "platform_config.h"
+#include "commands.h"
+#include "metrics.h"
+#include "processor_task.h"
+#include "pwm_backend.h"
+#include "seqlock.h"
+#include "spsc_ring.h"
+#include "telemetry.h"
+#include "trace.h"
+#include <string.h>
 
 // ---------- Internal state ----------
 namespace
 {
   ProcessorConfig G; // copy of user config
+  Bridge B;          // IN1/IN2 legs, backend picked at compile time
   constexpr uint32_t PWM_MAX_MASKS[13] = {
       0, 1, 3, 7, 15, 31, 63, 127, 255, 511, 1023, 2047, 4095};
 
@@ -17,102 +29,471 @@ namespace
     return PWM_MAX_MASKS[b];
   }
 
-  inline uint16_t PercentageToDutyCycle(float pct)
+  // Percentages are Q16 fixed point (65536 = 1%); floats only appear where values enter the
+  // processor (config, commands), never on the per-tick path
+  constexpr uint32_t PCT_Q16_ONE = 1u << 16;
+  constexpr uint32_t PCT_Q16_MAX = 100u * PCT_Q16_ONE;
+
+  inline uint32_t PercentToQ16(float pct)
+  {
+    if (!(pct > 0.0f)) // also catches NaN
+      return 0;
+    if (pct >= 100.0f)
+      return PCT_Q16_MAX;
+    return (uint32_t)(pct * (float)PCT_Q16_ONE + 0.5f);
+  }
+
+  inline uint16_t DutyFromQ16(uint32_t pctQ16)
   {
-    if (pct < 0)
-      pct = 0;
-    if (pct > 100)
-      pct = 100;
-    return (uint16_t)lroundf(pct * PwmMax() / 100.0f);
+    return (uint16_t)(((uint64_t)pctQ16 * PwmMax() + PCT_Q16_MAX / 2) / PCT_Q16_MAX);
   }
 
-  // Debounced buttons
-  struct Btn
+  // Whole and tenth digits for "%u.%u%%" log output
+  inline unsigned PctTenths(uint32_t pctQ16)
+  {
+    return (unsigned)(((uint64_t)pctQ16 * 10u + PCT_Q16_ONE / 2) >> 16);
+  }
+
+  // Cached duties, recomputed only when cruise or the PWM resolution changes
+  uint32_t cruisePctQ16 = 0;
+  uint16_t cruiseDuty = 0;
+  uint16_t halfDuty = 0;
+
+  void UpdateDutyCache()
   {
-    int pin;
-    bool lastStable{true}; // pull-up => idle high
-    bool lastRead{true};
-    uint32_t lastChangeMs{0};
+    cruiseDuty = DutyFromQ16(cruisePctQ16);
+    halfDuty = DutyFromQ16(50u * PCT_Q16_ONE);
+  }
+
+  // Debounced buttons (buttons.h); indices handed out by ButtonsAttach()
+  uint8_t startButton = BUTTON_NONE;
+
+  // Phase machine
+  using Phase = ProcessorPhase;
+  Phase phase = Phase::IDLE;
+  Phase tracedPhase = Phase::IDLE; // last phase written to the trace
+  bool running = false;
+  bool dirForward = true;
+
+  // Last duty written to the bridge, so ramps start from wherever the motor actually is
+  bool outForward = true;
+  uint16_t outDuty = 0;
+
+  inline void ApplyDuty(bool forward, uint16_t duty)
+  {
+    if (forward)
+      B.SetBridge(duty, 0); // forward drive on IN1, coast other leg
+    else
+      B.SetBridge(0, duty); // reverse drive on IN2
+    outForward = forward;
+    outDuty = duty;
+  }
+
+  // Non-blocking ramps: one duty step every RAMP_STEP_MS, advanced by ServiceRamp() from ServiceProcessor()
+  constexpr uint16_t RAMP_STEP_MS = 10;
+
+  struct Ramp
+  {
+    bool active{false};
+    bool forward{true}; // leg being driven (IN1 forward, IN2 reverse)
+    bool hardware{false}; // handed to the PWM fade engine; ServiceRamp() only waits for completion
+    uint16_t fromDuty{0};
+    uint16_t toDuty{0};
+    uint16_t steps{1};
+    uint16_t step{0};
+    RampProfile profile{RampProfile::LINEAR};
+    bool mirror{false};    // ramping toward standstill: play the profile mirrored
+    uint32_t posStepQ16{0}; // ramp fraction per step, Q16; the only division happens in StartRamp()
+    uint32_t nextStepMs{0};
+    uint32_t startMs{0};
   };
-  Btn Bstart;
+  Ramp R;
+
+  // Set from the fade-complete interrupt, consumed by ServiceRamp()
+  std::atomic<bool> fadeDone{false};
+  // Grace period before a fade whose completion interrupt never arrived is finished by hand
+  constexpr uint32_t FADE_TIMEOUT_MS = 50;
 
-  bool CheckButtonPress(Btn &b, uint16_t debounceMs = 30)
+  void HAL_ISR_ATTR OnFadeDone()
   {
-    bool r = digitalRead(b.pin); // HIGH released, LOW pressed
-    uint32_t now = millis();
-    if (r != b.lastRead)
+    fadeDone.store(true, std::memory_order_release);
+  }
+
+  // Duty on the driven leg right now; during a hardware fade it is interpolated from the clock
+  // (only needed when a command interrupts the fade, so the division is off the tick path)
+  uint16_t CurrentDuty()
+  {
+    if (!R.active || !R.hardware)
+      return outDuty;
+    const uint32_t elapsed = hal::Millis() - R.startMs;
+    const uint32_t total = (uint32_t)R.steps * RAMP_STEP_MS;
+    if (elapsed >= total)
+      return R.toDuty;
+    const int32_t span = (int32_t)R.toDuty - (int32_t)R.fromDuty;
+    return (uint16_t)(R.fromDuty + span * (int32_t)elapsed / (int32_t)total);
+  }
+
+  // One telemetry sample of both legs; duty is CurrentDuty(), so a hardware fade is interpolated
+  void RecordTelemetry(uint32_t nowUs, uint16_t duty)
+  {
+    uint32_t in1 = B.In1Duty();
+    uint32_t in2 = B.In2Duty();
+    uint8_t flags = (running ? TELEMETRY_RUNNING : 0) | (outForward ? TELEMETRY_FORWARD : 0);
+    if (R.active && R.hardware)
+    {
+      flags |= TELEMETRY_FADING;
+      (R.forward ? in1 : in2) = duty;
+    }
+    if (in1 > 0xFFFF || in2 > 0xFFFF)
+      flags |= TELEMETRY_UNKNOWN;
+    TelemetrySample s;
+    s.timeUs = nowUs;
+    s.in1 = (uint16_t)(in1 > 0xFFFF ? 0xFFFF : in1);
+    s.in2 = (uint16_t)(in2 > 0xFFFF ? 0xFFFF : in2);
+    s.phase = (uint8_t)phase;
+    s.flags = flags;
+    TelemetryRecord(s);
+  }
+
+  inline uint8_t RampTraceFlags()
+  {
+    return (R.forward ? TRACE_RAMP_FORWARD : 0) | (R.hardware ? TRACE_RAMP_HARDWARE : 0);
+  }
+
+  void StartRamp(bool forward, uint16_t targetDuty, uint16_t rampTime)
+  {
+    LOGFLN("Ramp%s: target=%d, rampTime=%d", forward ? "Forward" : "Reverse", targetDuty, rampTime);
+    const uint16_t current = CurrentDuty();
+    if (R.active)
+      TRACE(TraceEvent::RAMP_END, RampTraceFlags() | TRACE_RAMP_CANCELLED, current);
+    R.forward = forward;
+    R.fromDuty = (outForward == forward) ? current : 0;
+    R.toDuty = targetDuty;
+    R.steps = rampTime / RAMP_STEP_MS;
+    if (R.steps == 0)
+      R.steps = 1;
+    R.step = 0;
+    R.profile = G.t.rampProfile;
+    R.mirror = R.toDuty < R.fromDuty;
+    R.posStepQ16 = (1u << 16) / R.steps;
+    R.startMs = hal::Millis();
+    R.nextStepMs = R.startMs + RAMP_STEP_MS;
+    R.active = true;
+
+    // The fade engine is linear, so only linear ramps of more than one step are handed over.
+    // It runs for steps * RAMP_STEP_MS, the same time the software engine takes.
+    R.hardware = false;
+    if (G.hwFade && R.profile == RampProfile::LINEAR && R.steps > 1 && R.fromDuty != R.toDuty)
     {
-      b.lastRead = r;
-      b.lastChangeMs = now;
+      B.StopFade(); // so a late interrupt from the previous fade can't complete this one
+      fadeDone.store(false, std::memory_order_relaxed);
+      R.hardware = B.FadeLeg(forward, R.fromDuty, R.toDuty, (uint32_t)R.steps * RAMP_STEP_MS, OnFadeDone);
     }
-    if ((now - b.lastChangeMs) >= debounceMs && r != b.lastStable)
+    if (R.hardware)
     {
-      b.lastStable = r;
-      if (b.lastStable == LOW)
-        return true;
+      outForward = forward;
+      outDuty = R.fromDuty; // CurrentDuty() tracks the fade from here
     }
-    return false;
+    else
+    {
+      ApplyDuty(forward, R.fromDuty);
+    }
+    TRACE(TraceEvent::RAMP_START, RampTraceFlags(), R.toDuty, (uint32_t)R.fromDuty | (uint32_t)rampTime << 16);
   }
 
-  // Phase machine
-  enum class Phase
+  void CancelRamp()
   {
-    IDLE,
-    RUN_FWD,
-    RUN_REV
+    if (R.active && R.hardware)
+    {
+      outDuty = CurrentDuty();
+      B.StopFade();
+    }
+    if (R.active)
+      TRACE(TraceEvent::RAMP_END, RampTraceFlags() | TRACE_RAMP_CANCELLED, outDuty);
+    R.active = false;
+  }
+
+  void LogRampFinal(uint16_t d)
+  {
+    if (R.forward)
+      LOGFLN("RampForward final: IN1(pin %d)=%d, IN2(pin %d)=0", G.pins.in1, d, G.pins.in2);
+    else
+      LOGFLN("RampReverse final: IN1(pin %d)=0, IN2(pin %d)=%d", G.pins.in1, G.pins.in2, d);
+  }
+
+  // Writes at most one duty step per call; returns true once the ramp (if any) has finished
+  bool ServiceRamp(uint32_t now)
+  {
+    if (!R.active)
+      return true;
+
+    if (R.hardware)
+    {
+      const uint32_t endMs = R.startMs + (uint32_t)R.steps * RAMP_STEP_MS;
+      uint8_t flags = RampTraceFlags();
+      if (fadeDone.load(std::memory_order_acquire))
+      {
+        B.FadeFinished();
+        outDuty = R.toDuty;
+      }
+      else if ((int32_t)(now - endMs) >= (int32_t)FADE_TIMEOUT_MS)
+      {
+        ApplyDuty(R.forward, R.toDuty); // stops the fade and forces the target
+        flags |= TRACE_RAMP_TIMEOUT;
+      }
+      else
+      {
+        return false;
+      }
+      TRACE(TraceEvent::RAMP_END, flags, R.toDuty);
+      R.active = false;
+      LogRampFinal(R.toDuty);
+      return true;
+    }
+
+    if ((int32_t)(now - R.nextStepMs) < 0)
+      return false;
+
+    // Catch up on any steps a slow loop() pass skipped, then write only the latest duty
+    do
+    {
+      ++R.step;
+      R.nextStepMs += RAMP_STEP_MS;
+    } while (R.step < R.steps && (int32_t)(now - R.nextStepMs) >= 0);
+
+    uint16_t d = R.toDuty;
+    if (R.step < R.steps)
+    {
+      const int32_t span = (int32_t)R.toDuty - (int32_t)R.fromDuty;
+      const int32_t progress = (int32_t)RampProfileSample(R.profile, R.posStepQ16 * R.step, R.mirror);
+      d = (uint16_t)(R.fromDuty + ((span * progress + (int32_t)(RAMP_PROFILE_ONE / 2)) >> 15));
+    }
+    ApplyDuty(R.forward, d);
+
+    if (R.step < R.steps)
+      return false;
+
+    TRACE(TraceEvent::RAMP_END, RampTraceFlags(), d);
+    R.active = false;
+    LogRampFinal(d);
+    return true;
+  }
+
+  // Loop blocking statistics (how long ServiceProcessor holds loop(), and the worst gap between calls)
+  struct LoopStats
+  {
+    uint32_t calls{0};
+    uint32_t maxServiceUs{0};
+    uint64_t totalServiceUs{0};
+    uint32_t maxGapUs{0};
+    uint32_t lastEntryUs{0};
   };
-  Phase phase = Phase::IDLE;
-  bool running = false;
-  bool dirForward = true;
-  uint32_t phaseStartMs = 0;
+  LoopStats LS;
+
+  // Deadline scheduler: reversals fire at absolute deadlines, so ramp and coast time
+  // is spent out of the phase budget instead of being added on top of it
+  struct Scheduler
+  {
+    uint32_t reverseAtUs{0}; // absolute deadline for the next reversal (or stop of RUN)
+    uint32_t coastEndUs{0};  // absolute end of the current coast
+  };
+  Scheduler S;
+
+  // Scheduler and command stats are written by the processor thread only and read from any other
+  // (status JSON, metrics): relaxed load/store pairs, with 64-bit sums split so a reader can detect
+  // a carry between its two loads. The sample count is stored last (release), so a reader that
+  // loads it first (acquire) sees min/max/sum covering at least that many samples.
+  inline uint32_t Load(const std::atomic<uint32_t> &a) { return a.load(std::memory_order_relaxed); }
+  inline void Store(std::atomic<uint32_t> &a, uint32_t v) { a.store(v, std::memory_order_relaxed); }
+  inline void Bump(std::atomic<uint32_t> &a) { a.store(Load(a) + 1, std::memory_order_release); }
+
+  struct SplitSum
+  {
+    std::atomic<uint32_t> lo{0};
+    std::atomic<uint32_t> hi{0};
+
+    void Add(uint32_t v)
+    {
+      const uint32_t sum = Load(lo) + v;
+      if (sum < v)
+        Store(hi, Load(hi) + 1);
+      Store(lo, sum);
+    }
+
+    uint64_t Get() const
+    {
+      uint32_t h, l;
+      do
+      {
+        h = Load(hi);
+        l = Load(lo);
+      } while (h != Load(hi));
+      return ((uint64_t)h << 32) | l;
+    }
+  };
+
+  constexpr size_t LATENESS_BUCKETS = sizeof(PROCESSOR_LATENESS_EDGES_US) / sizeof(PROCESSOR_LATENESS_EDGES_US[0]) + 1;
+  static_assert(LATENESS_BUCKETS == PROCESSOR_LATENESS_BUCKETS, "lateness bucket count mismatch");
+
+  struct LatenessStats
+  {
+    std::atomic<uint32_t> transitions{0};
+    std::atomic<uint32_t> resyncs{0};
+    std::atomic<uint32_t> minUs{UINT32_MAX};
+    std::atomic<uint32_t> maxUs{0};
+    SplitSum totalUs;
+    std::atomic<uint32_t> hist[LATENESS_BUCKETS]{};
+  };
+  LatenessStats LT;
+
+  // Command queues (one SPSC ring per CommandSource), drained at the top of ServiceProcessor()
+  constexpr size_t COMMAND_QUEUE_SIZE = 16;
+  constexpr size_t COMMAND_SOURCES = 2;
+
+  struct QueuedCommand
+  {
+    ProcessorCommand cmd;
+    float arg;
+    uint32_t postedUs;
+  };
+  SpscRing<QueuedCommand, COMMAND_QUEUE_SIZE> commandQueues[COMMAND_SOURCES];
+
+  struct CommandStats
+  {
+    std::atomic<uint32_t> posted[COMMAND_SOURCES];   // written by each source's producer only
+    std::atomic<uint32_t> rejected[COMMAND_SOURCES];
+    std::atomic<uint32_t> executed{0};
+    std::atomic<uint32_t> minUs{UINT32_MAX};
+    std::atomic<uint32_t> maxUs{0};
+    SplitSum totalUs;
+  };
+  CommandStats CS;
+
+  // Limits keep a phase long enough to hold its own reversal and the deadline arithmetic wrap-safe
+  constexpr uint32_t MIN_RUN_MS = 500;
+  constexpr uint32_t MAX_RUN_MS = 30UL * 60UL * 1000UL;
+
+  void SetTiming(ProcessorCommand which, float ms)
+  {
+    // Checked as a float against the field's own range: converting anything outside it is undefined
+    const bool run = which == ProcessorCommand::SET_FORWARD_MS || which == ProcessorCommand::SET_REVERSE_MS;
+    const uint32_t maxMs = run ? MAX_RUN_MS : UINT16_MAX;
+    if (!(ms >= 0.0f && ms <= (float)maxMs))
+    {
+      LOGFLN("Timing rejected: %.1f ms out of range (0..%u)", ms, (unsigned)maxMs);
+      return;
+    }
+    const uint32_t v = (uint32_t)(ms + 0.5f);
+    ProcessorTimings t = G.t;
+    switch (which)
+    {
+      case ProcessorCommand::SET_FORWARD_MS:   t.forwardRunMs = v; break;
+      case ProcessorCommand::SET_REVERSE_MS:   t.reverseRunMs = v; break;
+      case ProcessorCommand::SET_RAMP_UP_MS:   t.rampUpMs = (uint16_t)v; break;
+      case ProcessorCommand::SET_RAMP_DOWN_MS: t.rampDownMs = (uint16_t)v; break;
+      case ProcessorCommand::SET_COAST_MS:     t.coastBetweenMs = (uint16_t)v; break;
+      case ProcessorCommand::SET_RAMP_PROFILE:
+        if (v >= RAMP_PROFILE_COUNT)
+        {
+          LOGFLN("Ramp profile rejected: use 0 (linear), 1 (s-curve) or 2 (exponential)");
+          return;
+        }
+        t.rampProfile = (RampProfile)v;
+        break;
+      default: return;
+    }
+    ProcessorCommandSetTimings(t);
+  }
+
+  void ExecuteCommand(const QueuedCommand &c)
+  {
+    switch (c.cmd)
+    {
+      case ProcessorCommand::MANUAL_FWD:  ProcessorCommandManualForward(); break;
+      case ProcessorCommand::MANUAL_REV:  ProcessorCommandManualReverse(); break;
+      case ProcessorCommand::COAST_STOP:  ProcessorCommandCoastStop(); break;
+      case ProcessorCommand::BRAKE_STOP:  ProcessorCommandBrakeStop(); break;
+      case ProcessorCommand::AUTO_START:  ProcessorCommandAutoStart(); break;
+      case ProcessorCommand::SET_CRUISE:  ProcessorCommandSetCruise(c.arg); break;
+      case ProcessorCommand::PRINT_STATE: ProcessorCommandPrintState(); break;
+      case ProcessorCommand::TEST_IN1:    ProcessorCommandTestIn1(); break;
+      case ProcessorCommand::TEST_IN2:    ProcessorCommandTestIn2(); break;
+      case ProcessorCommand::ALL_OFF:     ProcessorCommandAllOff(); break;
+      case ProcessorCommand::SET_FORWARD_MS:
+      case ProcessorCommand::SET_REVERSE_MS:
+      case ProcessorCommand::SET_RAMP_UP_MS:
+      case ProcessorCommand::SET_RAMP_DOWN_MS:
+      case ProcessorCommand::SET_COAST_MS:
+      case ProcessorCommand::SET_RAMP_PROFILE:
+        SetTiming(c.cmd, c.arg);
+        break;
+    }
+
+    const uint32_t latencyUs = hal::Micros() - c.postedUs;
+    if (latencyUs < Load(CS.minUs))
+      Store(CS.minUs, latencyUs);
+    if (latencyUs > Load(CS.maxUs))
+      Store(CS.maxUs, latencyUs);
+    CS.totalUs.Add(latencyUs);
+    Bump(CS.executed);
+  }
 
-  // Blocking ramps (short; fine for 200–300 ms)
-  void RampForward(uint16_t targetDuty, uint16_t rampTime)
+  void DrainCommands()
   {
-    LOGFLN("RampForward: target=%d, rampTime=%d", targetDuty, rampTime);
-    uint16_t steps = rampTime / 10;
-    if (steps == 0)
-      steps = 1;
-    for (uint16_t i = 0; i <= steps; ++i)
+    for (auto &q : commandQueues)
     {
-      uint16_t d = (uint32_t)targetDuty * i / steps;
-      #if defined(CONFIG_IDF_TARGET_ESP32C6) || defined(ESP32)
-            ledcWrite(G.pins.in2, 0); // coast other leg
-            ledcWrite(G.pins.in1, d); // forward drive on IN1
-            if (i == steps)
-              LOGFLN("RampForward final: IN1(pin %d)=%d, IN2(pin %d)=0", G.pins.in1, d, G.pins.in2);
-      #elif defined(ESP8266)
-            analogWrite(G.pins.in2, 0); // coast other leg
-            analogWrite(G.pins.in1, d); // forward drive on IN1
-      #endif
-            delay(10);
+      QueuedCommand c;
+      while (q.Pop(c))
+        ExecuteCommand(c);
     }
   }
-  void RampReverse(uint16_t targetDuty, uint16_t rampTime)
+
+  inline bool DeadlineReached(uint32_t nowUs, uint32_t deadlineUs)
+  {
+    return (int32_t)(nowUs - deadlineUs) >= 0; // wrap-safe for deadlines < ~35 min apart
+  }
+
+  void RecordLateness(uint32_t lateUs)
+  {
+    if (lateUs < Load(LT.minUs))
+      Store(LT.minUs, lateUs);
+    if (lateUs > Load(LT.maxUs))
+      Store(LT.maxUs, lateUs);
+    LT.totalUs.Add(lateUs);
+    size_t b = 0;
+    while (b < LATENESS_BUCKETS - 1 && lateUs >= PROCESSOR_LATENESS_EDGES_US[b])
+      ++b;
+    Store(LT.hist[b], Load(LT.hist[b]) + 1);
+    Bump(LT.transitions);
+  }
+
+  // Called when a RUN phase hits its deadline: records lateness and arms the next deadline
+  void AdvanceDeadline(uint32_t nowUs, uint32_t nextPhaseMs)
   {
-    LOGFLN("RampReverse: target=%d, rampTime=%d", targetDuty, rampTime);
-    uint16_t steps = rampTime / 10;
-    if (steps == 0)
-      steps = 1;
-    for (uint16_t i = 0; i <= steps; ++i)
+    const uint32_t lateUs = nowUs - S.reverseAtUs;
+    RecordLateness(lateUs);
+    S.reverseAtUs += nextPhaseMs * 1000u;
+    if (DeadlineReached(nowUs, S.reverseAtUs))
     {
-      uint16_t d = (uint32_t)targetDuty * i / steps;
-      #if defined(CONFIG_IDF_TARGET_ESP32C6) || defined(ESP32)
-            ledcWrite(G.pins.in1, 0);
-            ledcWrite(G.pins.in2, d); // reverse drive on IN2
-            if (i == steps)
-              LOGFLN("RampReverse final: IN1(pin %d)=0, IN2(pin %d)=%d", G.pins.in1, G.pins.in2, d);
-      #elif defined(ESP8266)
-            analogWrite(G.pins.in1, 0);
-            analogWrite(G.pins.in2, d); // reverse drive on IN2
-      #endif
-      delay(10);
+      // Fell behind by more than a whole phase (timings shortened mid-run?); restart the schedule from now
+      Store(LT.resyncs, Load(LT.resyncs) + 1);
+      S.reverseAtUs = nowUs + nextPhaseMs * 1000u;
     }
   }
+
+  // Status snapshot for other threads (dashboard push, /api/status); see ProcessorGetStatus()
+  SeqLock<ProcessorStatus> statusCell;
+  ProcessorStatus published;
+  bool publishedOnce = false;
+
+  inline bool SameTimings(const ProcessorTimings &a, const ProcessorTimings &b)
+  {
+    return a.rampUpMs == b.rampUpMs && a.rampDownMs == b.rampDownMs && a.coastBetweenMs == b.coastBetweenMs &&
+           a.forwardRunMs == b.forwardRunMs && a.reverseRunMs == b.reverseRunMs && a.rampProfile == b.rampProfile;
+  }
 } // namespace
 
-// TODO: Put this somewhere better
-static const char *phaseName(Phase p)
+const char *ProcessorPhaseName(ProcessorPhase p)
 {
   switch (p)
   {
@@ -122,6 +503,14 @@ static const char *phaseName(Phase p)
       return "RUN_FWD";
     case Phase::RUN_REV:
       return "RUN_REV";
+    case Phase::RAMP_UP:
+      return "RAMP_UP";
+    case Phase::RAMP_DOWN:
+      return "RAMP_DOWN";
+    case Phase::COAST:
+      return "COAST";
+    case Phase::STOPPING:
+      return "STOPPING";
     default:
       return "?";
   }
@@ -132,37 +521,22 @@ void InitializeProcessor(const ProcessorConfig &cfg)
 {
   G = cfg; // copy-by-value
 
-  // PWM setup - auto-detect platform
-  #if defined(CONFIG_IDF_TARGET_ESP32C6) || defined(ESP32)
-    // ESP32 and ESP32-C6 both use v3 LEDC API
-    ledcAttach(G.pins.in1, G.pwmHz, G.pwmBits);
-    ledcAttach(G.pins.in2, G.pwmHz, G.pwmBits);
-    LOGFLN("PWM setup: IN1=GPIO%d, IN2=GPIO%d, freq=%dHz, bits=%d", G.pins.in1, G.pins.in2, G.pwmHz, G.pwmBits);
-  #elif defined(ESP8266)
-    // ESP8266 uses analogWrite with analogWriteFreq
-    analogWriteFreq(G.pwmHz);
-    analogWriteRange(PwmMax()); // Set PWM range to match pwmBits
-    pinMode(G.pins.in1, OUTPUT);
-    pinMode(G.pins.in2, OUTPUT);
-  #endif
+  // PWM setup - platform backend lives in pwm_backend.h
+  B.Attach(G.pins.in1, G.pins.in2, G.pwmHz, G.pwmBits);
+  LOGFLN("PWM setup: IN1=GPIO%d, IN2=GPIO%d, freq=%dHz, bits=%d", G.pins.in1, G.pins.in2, G.pwmHz, G.pwmBits);
 
-  // Buttons
-  pinMode(G.pins.btnStart, INPUT_PULLUP);
-  // Init button state objects
-  Bstart.pin = G.pins.btnStart;
+  // Buttons: edge interrupts, debounced from ServiceProcessor()
+  startButton = ButtonsAttach(G.pins.btnStart);
 
   // Idle (coast)
-  #if defined(CONFIG_IDF_TARGET_ESP32C6) || defined(ESP32)
-    // ESP32 and ESP32-C6 both use pin-based ledcWrite with v3 API
-    ledcWrite(G.pins.in1, 0);
-    ledcWrite(G.pins.in2, 0);
-  #elif defined(ESP8266)
-    analogWrite(G.pins.in1, 0);
-    analogWrite(G.pins.in2, 0);
-  #endif
+  CoastStop();
+  outForward = true;
 
-  LOGFLN("Processor init: PWM=%dkHz bits=%d, cruise=%.1f%%",
-         G.pwmHz / 1000, G.pwmBits, G.cruisePct);
+  cruisePctQ16 = PercentToQ16(G.cruisePct);
+  UpdateDutyCache();
+  const unsigned tenths = PctTenths(cruisePctQ16);
+  LOGFLN("Processor init: PWM=%dkHz bits=%d, cruise=%u.%u%% (duty %u)",
+         G.pwmHz / 1000, G.pwmBits, tenths / 10, tenths % 10, (unsigned)cruiseDuty);
 }
 
 //--------------------------------
@@ -170,67 +544,50 @@ void InitializeProcessor(const ProcessorConfig &cfg)
 //--------------------------------
 void RunForwardDuty(uint16_t duty)
 {
-  #if defined(CONFIG_IDF_TARGET_ESP32C6) || defined(ESP32)
-    ledcWrite(G.pins.in2, 0); // coast leg
-    ledcWrite(G.pins.in1, duty);
-    LOGFLN("RunForwardDuty: IN1(pin %d)=%d, IN2(pin %d)=0", G.pins.in1, duty, G.pins.in2);
-  #elif defined(ESP8266)
-    analogWrite(G.pins.in2, 0); // coast leg
-    analogWrite(G.pins.in1, duty);
-  #endif
+  ApplyDuty(true, duty);
+  LOGFLN("RunForwardDuty: IN1(pin %d)=%d, IN2(pin %d)=0", G.pins.in1, duty, G.pins.in2);
 }
 
 void RunReverseDuty(uint16_t duty)
 {
-  #if defined(CONFIG_IDF_TARGET_ESP32C6) || defined(ESP32)
-    ledcWrite(G.pins.in1, 0);
-    ledcWrite(G.pins.in2, duty);
-    LOGFLN("RunReverseDuty: IN1(pin %d)=0, IN2(pin %d)=%d", G.pins.in1, G.pins.in2, duty);
-  #elif defined(ESP8266)
-    analogWrite(G.pins.in1, 0);
-    analogWrite(G.pins.in2, duty);
-  #endif
+  ApplyDuty(false, duty);
+  LOGFLN("RunReverseDuty: IN1(pin %d)=0, IN2(pin %d)=%d", G.pins.in1, G.pins.in2, duty);
 }
 
 void CoastStop()
 {
-  #if defined(CONFIG_IDF_TARGET_ESP32C6) || defined(ESP32)
-    ledcWrite(G.pins.in1, 0);
-    ledcWrite(G.pins.in2, 0);
-  #elif defined(ESP8266)
-    analogWrite(G.pins.in1, 0);
-    analogWrite(G.pins.in2, 0);
-  #endif
+  B.SetBridge(0, 0);
+  outDuty = 0;
 }
 
 void BrakeStop()
 {
   uint32_t maxd = PwmMax();
-  #if defined(CONFIG_IDF_TARGET_ESP32C6) || defined(ESP32)
-    ledcWrite(G.pins.in1, maxd);
-    ledcWrite(G.pins.in2, maxd);
-  #elif defined(ESP8266)
-    analogWrite(G.pins.in1, maxd);
-    analogWrite(G.pins.in2, maxd);
-  #endif
+  B.SetBridge(maxd, maxd);
+  outDuty = 0; // braked, next ramp starts from standstill
 }
 
 //--------------------------------
 // Shared command helpers (CLI & OTA)
 //--------------------------------
 
+// Manual jogs take over from the auto cycle; the ramp completes from ServiceProcessor()
 void ProcessorCommandManualForward()
 {
-  uint16_t d = PercentageToDutyCycle(G.cruisePct);
-  LOGFLN("Manual FWD %.1f%%", G.cruisePct);
-  RampForward(d, G.t.rampUpMs);
+  const unsigned tenths = PctTenths(cruisePctQ16);
+  LOGFLN("Manual FWD %u.%u%%", tenths / 10, tenths % 10);
+  running = false;
+  phase = Phase::IDLE;
+  StartRamp(true, cruiseDuty, G.t.rampUpMs);
 }
 
 void ProcessorCommandManualReverse()
 {
-  uint16_t d = PercentageToDutyCycle(G.cruisePct);
-  LOGFLN("Manual REV %.1f%%", G.cruisePct);
-  RampReverse(d, G.t.rampUpMs);
+  const unsigned tenths = PctTenths(cruisePctQ16);
+  LOGFLN("Manual REV %u.%u%%", tenths / 10, tenths % 10);
+  running = false;
+  phase = Phase::IDLE;
+  StartRamp(false, cruiseDuty, G.t.rampUpMs);
 }
 
 void ProcessorCommandCoastStop()
@@ -253,55 +610,156 @@ void ProcessorCommandAutoStart()
 
 void ProcessorCommandSetCruise(float pct)
 {
-  if (pct < 0.0f)
-    pct = 0.0f;
-  if (pct > 100.0f)
-    pct = 100.0f;
-  G.cruisePct = pct;
-  LOGFLN("Cruise set to %.1f%%", G.cruisePct);
+  ProcessorCommandSetCruiseQ16(PercentToQ16(pct));
+}
+
+void ProcessorCommandSetCruiseQ16(uint32_t pctQ16)
+{
+  cruisePctQ16 = pctQ16 > PCT_Q16_MAX ? PCT_Q16_MAX : pctQ16;
+  UpdateDutyCache();
+  const unsigned tenths = PctTenths(cruisePctQ16);
+  LOGFLN("Cruise set to %u.%u%% (duty %u)", tenths / 10, tenths % 10, (unsigned)cruiseDuty);
+}
+
+bool ProcessorCommandSetTimings(const ProcessorTimings &t)
+{
+  const uint32_t reversal = (uint32_t)t.rampDownMs + t.coastBetweenMs + t.rampUpMs;
+  const uint32_t shortest = t.forwardRunMs < t.reverseRunMs ? t.forwardRunMs : t.reverseRunMs;
+  if (t.forwardRunMs < MIN_RUN_MS || t.reverseRunMs < MIN_RUN_MS ||
+      t.forwardRunMs > MAX_RUN_MS || t.reverseRunMs > MAX_RUN_MS)
+  {
+    LOGFLN("Timings rejected: run times must be %u..%u ms", (unsigned)MIN_RUN_MS, (unsigned)MAX_RUN_MS);
+    return false;
+  }
+  if (reversal >= shortest)
+  {
+    LOGFLN("Timings rejected: ramp down+coast+ramp up (%u ms) must be shorter than a run (%u ms)",
+           (unsigned)reversal, (unsigned)shortest);
+    return false;
+  }
+  // The deadline already scheduled stands; new values apply from the next phase
+  G.t = t;
+  LOGFLN("Timings: fwd=%ums rev=%ums ramp up=%ums down=%ums (%s) coast=%ums",
+         (unsigned)G.t.forwardRunMs, (unsigned)G.t.reverseRunMs, (unsigned)G.t.rampUpMs,
+         (unsigned)G.t.rampDownMs, RampProfileName(G.t.rampProfile), (unsigned)G.t.coastBetweenMs);
+  return true;
 }
 
 void ProcessorCommandPrintState()
 {
-  LOGFLN("State: running=%d phase=%s duty=%.1f%%", (int)running, phaseName(phase), G.cruisePct);
+  const unsigned tenths = PctTenths(cruisePctQ16);
+  LOGFLN("State: running=%d phase=%s cruise=%u.%u%% (duty %u)", (int)running, ProcessorPhaseName(phase),
+         tenths / 10, tenths % 10, (unsigned)cruiseDuty);
+  LOGFLN("Timings: fwd=%ums rev=%ums ramp up=%ums down=%ums (%s) coast=%ums",
+         (unsigned)G.t.forwardRunMs, (unsigned)G.t.reverseRunMs, (unsigned)G.t.rampUpMs,
+         (unsigned)G.t.rampDownMs, RampProfileName(G.t.rampProfile), (unsigned)G.t.coastBetweenMs);
+  LOGFLN("Bridge: IN1=%u IN2=%u, peripheral writes=%u",
+         (unsigned)B.In1Duty(), (unsigned)B.In2Duty(), (unsigned)B.Writes());
+  const ProcessorCommandStats cs = ProcessorGetCommandStats();
+  LOGFLN("Commands: posted=%u executed=%u rejected=%u, post-to-actuation min=%uus max=%uus mean=%uus",
+         (unsigned)cs.posted, (unsigned)cs.executed, (unsigned)cs.rejected,
+         (unsigned)cs.minLatencyUs, (unsigned)cs.maxLatencyUs, (unsigned)cs.meanLatencyUs);
+  const LogStats ls = LogGetStats();
+  LOGFLN("Log ring: %u/%u queued, high water=%u, dropped=%u",
+         (unsigned)ls.pending, (unsigned)ls.capacity, (unsigned)ls.highWater, (unsigned)ls.dropped);
+  LOGFLN("Loop: calls=%u service max=%uus avg=%uus, max gap between calls=%uus",
+         (unsigned)LS.calls, (unsigned)LS.maxServiceUs,
+         (unsigned)(LS.calls ? LS.totalServiceUs / LS.calls : 0), (unsigned)LS.maxGapUs);
+  const ButtonStats bs = ButtonsGetStats();
+  LOGFLN("Buttons: presses=%u edges=%u edge ring overflows=%u",
+         (unsigned)bs.presses, (unsigned)bs.edges, (unsigned)bs.overflows);
+
+  const ProcessorSchedulerStats st = ProcessorGetSchedulerStats();
+  LOGFLN("Sched: transitions=%u resyncs=%u late min=%uus max=%uus mean=%uus",
+         (unsigned)st.transitions, (unsigned)st.resyncs, (unsigned)st.minLateUs,
+         (unsigned)st.maxLateUs, (unsigned)st.meanLateUs);
+  LOGFLN("Sched lateness hist [<10us <100us <1ms <10ms <100ms >=100ms]: %u %u %u %u %u %u",
+         (unsigned)st.histogram[0], (unsigned)st.histogram[1], (unsigned)st.histogram[2],
+         (unsigned)st.histogram[3], (unsigned)st.histogram[4], (unsigned)st.histogram[5]);
+  #if PROCESSOR_TASK
+    const ProcessorTaskStats task = ProcessorGetTaskStats();
+    if (task.running)
+      LOGFLN("Task: period=%uus ticks=%u overruns=%u worst wake lateness=%uus",
+             (unsigned)task.periodUs, (unsigned)task.ticks, (unsigned)task.overruns, (unsigned)task.maxLateUs);
+  #endif
+}
+
+bool ProcessorPostCommand(ProcessorCommand cmd, float arg, CommandSource src)
+{
+  const size_t i = (size_t)src;
+  const uint32_t nowUs = hal::Micros();
+#if ENABLE_TRACE
+  uint32_t argBits;
+  memcpy(&argBits, &arg, sizeof(argBits));
+#endif
+  if (!commandQueues[i].Push(QueuedCommand{cmd, arg, nowUs}))
+  {
+    TRACE_AT(nowUs, TraceEvent::COMMAND, (uint8_t)cmd, (uint16_t)src | TRACE_COMMAND_REJECTED, argBits);
+    CS.rejected[i].store(CS.rejected[i].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    return false;
+  }
+  TRACE_AT(nowUs, TraceEvent::COMMAND, (uint8_t)cmd, (uint16_t)src, argBits);
+  CS.posted[i].store(CS.posted[i].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  return true;
+}
+
+ProcessorCommandStats ProcessorGetCommandStats()
+{
+  ProcessorCommandStats st;
+  for (size_t i = 0; i < COMMAND_SOURCES; ++i)
+  {
+    st.posted += CS.posted[i].load(std::memory_order_relaxed);
+    st.rejected += CS.rejected[i].load(std::memory_order_relaxed);
+  }
+  st.executed = CS.executed.load(std::memory_order_acquire);
+  st.minLatencyUs = st.executed ? Load(CS.minUs) : 0;
+  st.maxLatencyUs = Load(CS.maxUs);
+  st.meanLatencyUs = st.executed ? (uint32_t)(CS.totalUs.Get() / st.executed) : 0;
+  return st;
+}
+
+uint32_t ProcessorGetPwmWrites()
+{
+  return B.Writes();
+}
+
+bool ProcessorGetStatus(ProcessorStatus &out, uint32_t &version)
+{
+  return statusCell.Read(out, version);
+}
+
+ProcessorSchedulerStats ProcessorGetSchedulerStats()
+{
+  ProcessorSchedulerStats st;
+  st.transitions = LT.transitions.load(std::memory_order_acquire);
+  st.resyncs = Load(LT.resyncs);
+  st.minLateUs = st.transitions ? Load(LT.minUs) : 0;
+  st.maxLateUs = Load(LT.maxUs);
+  st.meanLateUs = st.transitions ? (uint32_t)(LT.totalUs.Get() / st.transitions) : 0;
+  for (size_t i = 0; i < LATENESS_BUCKETS; ++i)
+    st.histogram[i] = Load(LT.hist[i]);
+  return st;
 }
 
 void ProcessorCommandTestIn1()
 {
   LOGFLN("Test GPIO%d only at 50%%", G.pins.in1);
-  uint16_t halfDuty = PercentageToDutyCycle(50.0f);
-  #if defined(CONFIG_IDF_TARGET_ESP32C6) || defined(ESP32)
-    ledcWrite(G.pins.in1, halfDuty);
-    ledcWrite(G.pins.in2, 0);
-  #elif defined(ESP8266)
-    analogWrite(G.pins.in1, halfDuty);
-    analogWrite(G.pins.in2, 0);
-  #endif
+  CancelRamp();
+  ApplyDuty(true, halfDuty);
 }
 
 void ProcessorCommandTestIn2()
 {
   LOGFLN("Test GPIO%d only at 50%%", G.pins.in2);
-  uint16_t halfDuty = PercentageToDutyCycle(50.0f);
-  #if defined(CONFIG_IDF_TARGET_ESP32C6) || defined(ESP32)
-    ledcWrite(G.pins.in1, 0);
-    ledcWrite(G.pins.in2, halfDuty);
-  #elif defined(ESP8266)
-    analogWrite(G.pins.in1, 0);
-    analogWrite(G.pins.in2, halfDuty);
-  #endif
+  CancelRamp();
+  ApplyDuty(false, halfDuty);
 }
 
 void ProcessorCommandAllOff()
 {
   LOGFLN("Turn off both motor pins");
-  #if defined(CONFIG_IDF_TARGET_ESP32C6) || defined(ESP32)
-    ledcWrite(G.pins.in1, 0);
-    ledcWrite(G.pins.in2, 0);
-  #elif defined(ESP8266)
-    analogWrite(G.pins.in1, 0);
-    analogWrite(G.pins.in2, 0);
-  #endif
+  CancelRamp();
+  CoastStop();
 }
 
 //--------------------------------
@@ -309,29 +767,32 @@ void ProcessorCommandAllOff()
 //--------------------------------
 void StartContinuousCycle()
 {
-  uint16_t cruise = PercentageToDutyCycle(G.cruisePct);
   running = true;
-  dirForward = true;
+  dirForward = (CurrentDuty() > 0) ? outForward : true; // restarting mid-stop keeps the current direction
 
-  RampForward(cruise, G.t.rampUpMs);
-  phase = Phase::RUN_FWD;
-  phaseStartMs = millis();
+  StartRamp(dirForward, cruiseDuty, G.t.rampUpMs);
+  phase = Phase::RAMP_UP;
+  S.reverseAtUs = hal::Micros() + (dirForward ? G.t.forwardRunMs : G.t.reverseRunMs) * 1000u;
 }
 
+// Ramps down from ServiceProcessor(); phase reaches IDLE once the motor is coasting
 void StopCycleCoast()
 {
-  uint16_t zero = 0;
-  if (phase == Phase::RUN_FWD)
-    RampForward(zero, G.t.rampDownMs);
-  else if (phase == Phase::RUN_REV)
-    RampReverse(zero, G.t.rampDownMs);
-  CoastStop();
   running = false;
-  phase = Phase::IDLE;
+  if (CurrentDuty() == 0)
+  {
+    CancelRamp();
+    CoastStop();
+    phase = Phase::IDLE;
+    return;
+  }
+  StartRamp(outForward, 0, G.t.rampDownMs);
+  phase = Phase::STOPPING;
 }
 
 void StopCycleBrake()
 {
+  CancelRamp();
   BrakeStop();
   running = false;
   phase = Phase::IDLE;
@@ -339,9 +800,21 @@ void StopCycleBrake()
 
 void ServiceProcessor()
 {
-  // Handle button (toggle state)
-  if (CheckButtonPress(Bstart))
+  METRICS_SCOPE(MetricProbe::SERVICE_PROCESSOR);
+  const uint32_t entryUs = hal::Micros();
+  if (LS.calls > 0 && entryUs - LS.lastEntryUs > LS.maxGapUs)
+    LS.maxGapUs = entryUs - LS.lastEntryUs;
+  LS.lastEntryUs = entryUs;
+
+  // Commands posted from other contexts (WebSocket, serial)
+  DrainCommands();
+
+  // Handle button (toggle state); every queued press counts, even if this call came late
+  uint8_t pressed;
+  while (ButtonsPoll(entryUs, pressed))
   {
+    if (pressed != startButton)
+      continue;
     LOGFLN("Button pressed (toggle)");
     if (!running)
     {
@@ -354,39 +827,53 @@ void ServiceProcessor()
   }
 
   //-----------------------------------------------------------------
-  // Phase Machine (non-blocking except short ramps at transitions)
+  // Phase Machine (non-blocking; ramps advance one step per call,
+  // timed exits are absolute deadlines so cycles never drift)
   //-----------------------------------------------------------------
-  if (!running)
-    return;
-
-  uint32_t now = millis();
-  uint16_t cruise = PercentageToDutyCycle(G.cruisePct);
+  const uint32_t nowUs = hal::Micros();
+  const bool rampDone = ServiceRamp(hal::Millis());
 
   switch (phase)
   {
+    case Phase::RAMP_UP:
+      if (rampDone)
+        phase = dirForward ? Phase::RUN_FWD : Phase::RUN_REV;
+      break;
+
     case Phase::RUN_FWD:
-      dirForward = true;
-      if (now - phaseStartMs >= G.t.forwardRunMs)
+    case Phase::RUN_REV:
+      if (DeadlineReached(nowUs, S.reverseAtUs))
+      {
+        // Ramp down, coast and ramp up all come out of the next phase's budget
+        AdvanceDeadline(nowUs, dirForward ? G.t.reverseRunMs : G.t.forwardRunMs);
+        StartRamp(dirForward, 0, G.t.rampDownMs);
+        phase = Phase::RAMP_DOWN;
+      }
+      break;
+
+    case Phase::RAMP_DOWN:
+      if (rampDone)
       {
-        RampForward(0, G.t.rampDownMs);
         CoastStop();
-        delay(G.t.coastBetweenMs);
-        RampReverse(cruise, G.t.rampUpMs);
-        phase = Phase::RUN_REV;
-        phaseStartMs = millis();
+        phase = Phase::COAST;
+        S.coastEndUs = nowUs + G.t.coastBetweenMs * 1000u;
       }
       break;
 
-    case Phase::RUN_REV:
-      dirForward = false;
-      if (now - phaseStartMs >= G.t.reverseRunMs)
+    case Phase::COAST:
+      if (DeadlineReached(nowUs, S.coastEndUs))
+      {
+        dirForward = !dirForward;
+        StartRamp(dirForward, cruiseDuty, G.t.rampUpMs);
+        phase = Phase::RAMP_UP;
+      }
+      break;
+
+    case Phase::STOPPING:
+      if (rampDone)
       {
-        RampReverse(0, G.t.rampDownMs);
         CoastStop();
-        delay(G.t.coastBetweenMs);
-        RampForward(cruise, G.t.rampUpMs);
-        phase = Phase::RUN_FWD;
-        phaseStartMs = millis();
+        phase = Phase::IDLE;
       }
       break;
 
@@ -394,62 +881,83 @@ void ServiceProcessor()
     default:
       break;
   }
-}
 
-void HandleSerialCLI()
-{
-  if (!Serial.available())
-    return;
-  const char cmd = Serial.read();
-
-  if (cmd == 'f')
-  {
-    ProcessorCommandManualForward();
-  }
-  else if (cmd == 'r')
-  {
-    ProcessorCommandManualReverse();
-  }
-  else if (cmd == 'c')
-  {
-    ProcessorCommandCoastStop();
-  }
-  else if (cmd == 'b')
-  {
-    ProcessorCommandBrakeStop();
-  }
-  else if (cmd == 'a')
+  // Publish only on change: a few compares per tick, one seqlock write per change
+  const uint16_t duty = CurrentDuty();
+  if (!publishedOnce || phase != published.phase || running != published.running || outForward != published.forward ||
+      duty != published.duty || cruisePctQ16 != published.cruisePctQ16 || !SameTimings(G.t, published.t))
   {
-    ProcessorCommandAutoStart();
+    published.phase = phase;
+    published.running = running;
+    published.forward = outForward;
+    published.duty = duty;
+    published.dutyMax = (uint16_t)PwmMax();
+    published.cruisePctQ16 = cruisePctQ16;
+    published.t = G.t;
+    publishedOnce = true;
+    statusCell.Write(published);
   }
-  else if (cmd == 'u')
-  {
-    while (!Serial.available())
-    { /* wait for serial */
-    }
 
-    float pct = Serial.parseFloat();
-    ProcessorCommandSetCruise(pct);
-  }
-  else if (cmd == 'p')
-  {
-    ProcessorCommandPrintState();
-  }
-  else if (cmd == '1')
-  {
-    ProcessorCommandTestIn1();
-  }
-  else if (cmd == '2')
+  if (phase != tracedPhase)
   {
-    ProcessorCommandTestIn2();
+    TRACE_AT(nowUs, TraceEvent::PHASE, (uint8_t)phase, (uint16_t)tracedPhase);
+    tracedPhase = phase;
   }
-  else if (cmd == '0')
-  {
-    ProcessorCommandAllOff();
-  }
-  else
+
+  // Duty/phase samples for the binary telemetry stream, only while a client listens
+  if (TelemetryDue(nowUs))
+    RecordTelemetry(nowUs, duty);
+
+  const uint32_t serviceUs = hal::Micros() - entryUs;
+  if (serviceUs > LS.maxServiceUs)
+    LS.maxServiceUs = serviceUs;
+  LS.totalServiceUs += serviceUs;
+  ++LS.calls;
+}
+
+#if defined(ARDUINO)
+// Bytes consumed per call; a pasted burst is spread over several loop() passes
+constexpr size_t SERIAL_CLI_BYTES_PER_PASS = 32;
+
+void HandleSerialCLI()
+{
+  static CommandLineEditor editor;
+
+  for (size_t n = 0; n < SERIAL_CLI_BYTES_PER_PASS && Serial.available(); ++n)
   {
-    LOGFLN("Commands: f=FWD, r=REV, c=COAST, b=BRAKE, a=AUTO, u[%%], p=print, 1=test GPIO2, 2=test GPIO3, 0=off");
+    const char c = (char)Serial.read();
+    switch (editor.Feed(c))
+    {
+      case CommandLineEditor::Event::ECHO:
+        Serial.write(c);
+        break;
+      case CommandLineEditor::Event::ERASE:
+        Serial.print("\b \b");
+        break;
+      case CommandLineEditor::Event::CLEAR:
+        Serial.print("\r\x1b[K");
+        break;
+      case CommandLineEditor::Event::TOO_LONG:
+        Serial.printf("\r\nLine too long (max %u characters) - discarded\r\n", (unsigned)CommandLineEditor::MAX_LINE);
+        break;
+      case CommandLineEditor::Event::LINE:
+      {
+        Serial.print("\r\n");
+        if (editor.Length() == 0)
+          break;
+        // Feedback goes straight to Serial: the line buffer is reused before a deferred log would drain
+        const CommandResult r = DispatchCommand(editor.Line(), editor.Length(), CommandContext{CommandSource::CONSOLE, 0});
+        if (r == CommandResult::UNKNOWN)
+          Serial.printf("Unknown command '%s' - '?' lists commands\r\n", editor.Line());
+        else if (r == CommandResult::MISSING_ARG)
+          Serial.printf("Missing argument: '%s'\r\n", editor.Line());
+        else if (r == CommandResult::BAD_ARG)
+          Serial.printf("Bad argument: '%s'\r\n", editor.Line());
+        break;
+      }
+      case CommandLineEditor::Event::NONE:
+        break;
+    }
   }
 }
 
@@ -465,15 +973,6 @@ void setupSerial(bool waitForSerial, uint32_t baudRate, uint32_t waitTimeMs)
       // Optional wait for serial connection
     }
   }
-  LOGFLN("Serial initialized at %u baud on platform: %s", baudRate,
-          #if defined(CONFIG_IDF_TARGET_ESP32C6)
-                  "ESP32-C6"
-          #elif defined(ESP32)
-                  "ESP32"
-          #elif defined(ESP8266)
-                  "ESP8266"
-          #else
-                  "Unknown"
-          #endif
-      );
+  LOGFLN("Serial initialized at %u baud on platform: %s", baudRate, getPlatformName());
 }
+#endif // ARDUINO
@@ -1,15 +1,15 @@
 #pragma once
-#include <Arduino.h>
-
-// Optional web dashboard log mirroring (implemented in ota_server.cpp when ENABLE_OTA=1)
-void OtaLogLinef(const char *fmt, ...);
+#include "hal.h"
+#include "deferred_log.h"
+#include "ramp_profile.h"
 
 // If LOGF/LOGFLN defined elsewhere, these won't override them.
+// Both only queue a record; LogDrain() prints it to Serial and mirrors LOGFLN lines to the dashboard.
 #ifndef LOGF
-  #define LOGF(...)   do { Serial.printf(__VA_ARGS__); } while(0)
+  #define LOGF(...)   do { LogDeferred(false, __VA_ARGS__); } while(0)
 #endif
 #ifndef LOGFLN
-  #define LOGFLN(...) do { Serial.printf(__VA_ARGS__); Serial.println(); OtaLogLinef(__VA_ARGS__); } while(0)
+  #define LOGFLN(...) do { LogDeferred(true, __VA_ARGS__); } while(0)
 #endif
 
 struct ProcessorPins {
@@ -24,6 +24,7 @@ struct ProcessorTimings {
   uint16_t coastBetweenMs= 500;
   uint32_t forwardRunMs  = 10000; // 10 s
   uint32_t reverseRunMs  = 10000; // 10 s
+  RampProfile rampProfile = RampProfile::LINEAR; // shape of every ramp (see ramp_profile.h)
 };
 
 struct ProcessorConfig {
@@ -33,8 +34,45 @@ struct ProcessorConfig {
   int pwmBits = 11;      // duty 0..(2^bits-1) (ESP32/ESP32-C6: up to 14-bit, ESP8266: 10-bit)
   int chIn1   = 0;       // LEDC channel for IN1 (ESP32/ESP32-C6 only, ignored on ESP8266)
   int chIn2   = 1;       // LEDC channel for IN2 (ESP32/ESP32-C6 only, ignored on ESP8266)
+  bool hwFade = true;    // run linear ramps on the PWM fade engine where the backend has one
   // Motion
-  float cruisePct = 65.0f; // nominal duty %
+  float cruisePct = 65.0f; // nominal duty %, converted to fixed point once by InitializeProcessor()
+  ProcessorTimings t;
+};
+
+// Reversal lateness (actual transition time minus its absolute deadline), in microseconds.
+// Histogram buckets are split at these edges, plus a final overflow bucket.
+constexpr uint32_t PROCESSOR_LATENESS_EDGES_US[] = {10, 100, 1000, 10000, 100000};
+constexpr size_t PROCESSOR_LATENESS_BUCKETS = 6;
+
+struct ProcessorSchedulerStats {
+  uint32_t transitions = 0; // reversals fired by the deadline scheduler
+  uint32_t resyncs     = 0; // times the schedule fell a whole phase behind and restarted
+  uint32_t minLateUs   = 0;
+  uint32_t maxLateUs   = 0;
+  uint32_t meanLateUs  = 0;
+  uint32_t histogram[PROCESSOR_LATENESS_BUCKETS] = {};
+};
+
+enum class ProcessorPhase : uint8_t {
+  IDLE,
+  RAMP_UP,   // ramping toward cruise in the cycle direction
+  RUN_FWD,
+  RUN_REV,
+  RAMP_DOWN, // ramping to zero ahead of a reversal
+  COAST,     // coasting between directions
+  STOPPING   // ramping to zero ahead of a coast stop
+};
+const char *ProcessorPhaseName(ProcessorPhase phase);
+
+// Motor state as last published by ServiceProcessor(), which republishes only when a field changed
+struct ProcessorStatus {
+  ProcessorPhase phase   = ProcessorPhase::IDLE;
+  bool running           = false; // auto cycle active
+  bool forward           = true;  // leg being driven (or last driven)
+  uint16_t duty          = 0;     // on that leg, 0..dutyMax (interpolated during hardware fades)
+  uint16_t dutyMax       = 0;
+  uint32_t cruisePctQ16  = 0;     // 65536 = 1%
   ProcessorTimings t;
 };
 
@@ -49,15 +87,18 @@ void BrakeStop();
 
 // Start/stop high-level patterns
 void StartContinuousCycle();  // begin alternating forward/reverse pattern
-void StopCycleCoast();        // ramp down then coast
+void StopCycleCoast();        // ramp down (serviced by ServiceProcessor) then coast
 void StopCycleBrake();        // brake, sets running=false & phase=IDLE
 
 // Service functions (call from loop)
-void ServiceProcessor();      // buttons, timed stop, phase machine
+void ServiceProcessor();      // buttons, ramps, phase machine (never blocks)
+
+#if defined(ARDUINO)
 void HandleSerialCLI();       // optional USB CLI (noop if no data)
 
 // Serial setup and configuration
 void setupSerial(bool waitForSerial = true, uint32_t baudRate = 115200, uint32_t waitTimeMs = 1500);
+#endif
 
 // Shared command helpers (used by serial CLI and OTA dashboard)
 void ProcessorCommandManualForward();
@@ -66,7 +107,63 @@ void ProcessorCommandCoastStop();
 void ProcessorCommandBrakeStop();
 void ProcessorCommandAutoStart();
 void ProcessorCommandSetCruise(float pct);
+void ProcessorCommandSetCruiseQ16(uint32_t pctQ16); // Q16 percent: 65536 = 1%
+bool ProcessorCommandSetTimings(const ProcessorTimings &t); // validated; false (and unchanged) if rejected
 void ProcessorCommandPrintState();
 void ProcessorCommandTestIn1();
 void ProcessorCommandTestIn2();
 void ProcessorCommandAllOff();
+
+// Scheduler jitter statistics (for the serial 'p' command and /api/status); any thread
+ProcessorSchedulerStats ProcessorGetSchedulerStats();
+
+// Queued commands: other contexts (e.g. the AsyncTCP task) post typed commands and ServiceProcessor()
+// runs them, so all motor state is only ever touched from the thread that services the processor
+// (the processor task, or loop() where there is none; see processor_task.h).
+enum class ProcessorCommand : uint8_t {
+  MANUAL_FWD,
+  MANUAL_REV,
+  COAST_STOP,
+  BRAKE_STOP,
+  AUTO_START,
+  SET_CRUISE,  // arg = cruise %
+  PRINT_STATE,
+  TEST_IN1,
+  TEST_IN2,
+  ALL_OFF,
+  SET_FORWARD_MS, // arg = ms; timing changes apply from the next phase
+  SET_REVERSE_MS,
+  SET_RAMP_UP_MS,
+  SET_RAMP_DOWN_MS,
+  SET_COAST_MS,
+  SET_RAMP_PROFILE // arg = RampProfile value
+};
+
+// One lock-free SPSC queue per posting context; each source must only ever post from one thread
+enum class CommandSource : uint8_t {
+  NETWORK, // AsyncTCP callbacks (WebSocket, OTA)
+  CONSOLE  // loop() context (serial CLI)
+};
+
+// Returns false if the queue is full (the command is dropped and counted)
+bool ProcessorPostCommand(ProcessorCommand cmd, float arg = 0.0f, CommandSource src = CommandSource::NETWORK);
+
+// Post-to-actuation latency: time from ProcessorPostCommand() until the command has run and
+// written its first PWM update (or started its ramp), in microseconds
+struct ProcessorCommandStats {
+  uint32_t posted      = 0;
+  uint32_t executed    = 0;
+  uint32_t rejected    = 0; // queue full
+  uint32_t minLatencyUs  = 0;
+  uint32_t maxLatencyUs  = 0;
+  uint32_t meanLatencyUs = 0;
+};
+ProcessorCommandStats ProcessorGetCommandStats(); // any thread
+
+// PWM peripheral writes actually issued (shadowed no-op writes are not counted); any thread
+uint32_t ProcessorGetPwmWrites();
+
+// Latest published status, safe from any thread (seqlock, never blocks the processor). version
+// increases with every change. False only before the first ServiceProcessor() call or if the
+// read kept overlapping a publish; try again on the next pass.
+bool ProcessorGetStatus(ProcessorStatus &out, uint32_t &version);
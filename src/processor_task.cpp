@@ -0,0 +1,188 @@
+#include "processor_task.h"
+
+#if PROCESSOR_TASK
+
+#if !defined(ARDUINO)
+  #include <pthread.h>
+  #include <sched.h>
+  #include <time.h>
+  #include "sim/hal_sim.h"
+#endif
+
+namespace
+{
+  // Written by the task only; relaxed loads elsewhere are fine for statistics
+  struct TaskCounters
+  {
+    std::atomic<uint32_t> ticks{0};
+    std::atomic<uint32_t> overruns{0};
+    std::atomic<uint32_t> maxLateUs{0};
+    std::atomic<uint32_t> periodUs{0};
+    std::atomic<bool> running{false};
+  };
+  TaskCounters TC;
+
+  inline void Bump(std::atomic<uint32_t> &counter)
+  {
+    counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  }
+
+  void RecordWake(uint32_t lateUs, uint32_t periodUs)
+  {
+    if (lateUs > TC.maxLateUs.load(std::memory_order_relaxed))
+      TC.maxLateUs.store(lateUs, std::memory_order_relaxed);
+    if (lateUs >= periodUs)
+      Bump(TC.overruns);
+  }
+
+#if defined(ESP32)
+  TaskHandle_t taskHandle = nullptr;
+
+  void TaskMain(void *)
+  {
+    LogBindProducer(LogProducer::MOTOR);
+    const uint32_t periodUs = TC.periodUs.load(std::memory_order_relaxed);
+    const TickType_t periodTicks = periodUs / (portTICK_PERIOD_MS * 1000u) > 0
+                                       ? (TickType_t)(periodUs / (portTICK_PERIOD_MS * 1000u))
+                                       : (TickType_t)1;
+    const uint32_t tickUs = (uint32_t)periodTicks * portTICK_PERIOD_MS * 1000u;
+
+    TickType_t lastWake = xTaskGetTickCount();
+    uint32_t expectedUs = micros();
+    for (;;)
+    {
+      ServiceProcessor();
+      Bump(TC.ticks);
+
+      // Fixed-rate schedule: sleeps until the next tick boundary regardless of how long servicing took
+      xTaskDelayUntil(&lastWake, periodTicks);
+      expectedUs += tickUs;
+      const int32_t late = (int32_t)(micros() - expectedUs);
+      RecordWake(late > 0 ? (uint32_t)late : 0u, tickUs);
+      if (late >= (int32_t)tickUs)
+        expectedUs = micros(); // FreeRTOS skipped ahead; re-anchor instead of reporting it forever
+    }
+  }
+#else
+  pthread_t thread;
+  bool threadStarted = false;
+  bool threadPaced = true;
+
+  inline uint64_t MonotonicUs()
+  {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+  }
+
+  void *TaskMain(void *)
+  {
+    LogBindProducer(LogProducer::MOTOR);
+    const uint32_t periodUs = TC.periodUs.load(std::memory_order_relaxed);
+    uint64_t nextUs = MonotonicUs();
+    while (TC.running.load(std::memory_order_acquire))
+    {
+      hal::sim::AdvanceUs(periodUs);
+      ServiceProcessor();
+      Bump(TC.ticks);
+
+      if (!threadPaced)
+      {
+        sched_yield(); // let the producers interleave even on a single core
+        continue;
+      }
+      nextUs += periodUs;
+      const timespec wake = {(time_t)(nextUs / 1000000u), (long)((nextUs % 1000000u) * 1000u)};
+      clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wake, nullptr);
+      const uint64_t now = MonotonicUs();
+      RecordWake(now > nextUs ? (uint32_t)(now - nextUs) : 0u, periodUs);
+      if (now >= nextUs + periodUs)
+        nextUs = now; // fell behind by a whole period; re-anchor
+    }
+    return nullptr;
+  }
+#endif
+} // namespace
+
+#if defined(ESP32)
+bool StartProcessorTask(uint32_t periodUs)
+{
+  if (taskHandle)
+    return true;
+  TC.periodUs.store(periodUs, std::memory_order_relaxed);
+  TC.running.store(true, std::memory_order_release);
+  const BaseType_t ok = xTaskCreatePinnedToCore(TaskMain, "processor", PROCESSOR_TASK_STACK, nullptr,
+                                                PROCESSOR_TASK_PRIORITY, &taskHandle, PROCESSOR_TASK_CORE);
+  if (ok != pdPASS)
+  {
+    TC.running.store(false, std::memory_order_relaxed);
+    taskHandle = nullptr;
+    LOGFLN("Processor task creation failed");
+    return false;
+  }
+  LOGFLN("Processor task: core %d, priority %d, period %uus", (int)PROCESSOR_TASK_CORE,
+         (int)PROCESSOR_TASK_PRIORITY, (unsigned)periodUs);
+  return true;
+}
+#else
+bool StartProcessorTask(uint32_t periodUs)
+{
+  return StartProcessorTask(periodUs, true);
+}
+
+bool StartProcessorTask(uint32_t periodUs, bool paced)
+{
+  if (threadStarted)
+    return true;
+  TC.periodUs.store(periodUs, std::memory_order_relaxed);
+  TC.running.store(true, std::memory_order_release);
+  threadPaced = paced;
+
+  // Real-time FIFO scheduling when permitted (root/CAP_SYS_NICE), mirroring the pinned ESP32 task.
+  // Never for a free-running thread: it would never sleep and starve everything else on its core.
+  int rc = -1;
+  if (paced)
+  {
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    sched_param sp{};
+    sp.sched_priority = sched_get_priority_min(SCHED_FIFO) + 10;
+    pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+    pthread_attr_setschedpolicy(&attr, SCHED_FIFO);
+    pthread_attr_setschedparam(&attr, &sp);
+    rc = pthread_create(&thread, &attr, TaskMain, nullptr);
+    pthread_attr_destroy(&attr);
+  }
+  if (rc != 0)
+    rc = pthread_create(&thread, nullptr, TaskMain, nullptr); // unprivileged: default policy
+  if (rc != 0)
+  {
+    TC.running.store(false, std::memory_order_relaxed);
+    return false;
+  }
+  threadStarted = true;
+  return true;
+}
+
+void StopProcessorTask()
+{
+  if (!threadStarted)
+    return;
+  TC.running.store(false, std::memory_order_release);
+  pthread_join(thread, nullptr);
+  threadStarted = false;
+}
+#endif
+
+ProcessorTaskStats ProcessorGetTaskStats()
+{
+  ProcessorTaskStats st;
+  st.ticks = TC.ticks.load(std::memory_order_relaxed);
+  st.overruns = TC.overruns.load(std::memory_order_relaxed);
+  st.maxLateUs = TC.maxLateUs.load(std::memory_order_relaxed);
+  st.periodUs = TC.periodUs.load(std::memory_order_relaxed);
+  st.running = TC.running.load(std::memory_order_relaxed);
+  return st;
+}
+
+#endif // PROCESSOR_TASK
@@ -0,0 +1,59 @@
+#pragma once
+
+// Real-time processor task: ServiceProcessor() runs on a fixed tick in its own high-priority thread,
+// pinned away from networking, instead of sharing loop() with the CLI, OTA and log drain.
+// Everything else reaches it only through the lock-free command queues (ProcessorPostCommand) and
+// per-producer log rings, so nothing on the network side can add jitter to phase timing.
+//
+// ESP32/ESP32-C6: FreeRTOS task paced by xTaskDelayUntil(). Native: a pthread paced by
+// clock_nanosleep(), used to stress-test the same queues on Linux. ESP8266 has no preemptive
+// threads for the sketch, so it keeps calling ServiceProcessor() from loop().
+
+#include "processor.h"
+
+#ifndef PROCESSOR_TASK
+  #if defined(ESP32) || !defined(ARDUINO)
+    #define PROCESSOR_TASK 1
+  #else
+    #define PROCESSOR_TASK 0
+  #endif
+#endif
+
+#ifndef PROCESSOR_TASK_PERIOD_US
+  #define PROCESSOR_TASK_PERIOD_US 1000 // rounded to whole FreeRTOS ticks on ESP32
+#endif
+
+#if defined(ESP32)
+  #ifndef PROCESSOR_TASK_PRIORITY
+    #define PROCESSOR_TASK_PRIORITY 10 // above loopTask (1) and AsyncTCP (3), below WiFi/lwIP
+  #endif
+  #ifndef PROCESSOR_TASK_CORE
+    #define PROCESSOR_TASK_CORE (portNUM_PROCESSORS > 1 ? 1 : 0) // WiFi lives on core 0
+  #endif
+  #ifndef PROCESSOR_TASK_STACK
+    #define PROCESSOR_TASK_STACK 4096 // bytes
+  #endif
+#endif
+
+struct ProcessorTaskStats {
+  uint32_t ticks      = 0;
+  uint32_t overruns   = 0; // wakeups more than one period late (missed ticks)
+  uint32_t maxLateUs  = 0; // worst wakeup lateness against the fixed schedule
+  uint32_t periodUs   = 0;
+  bool running        = false;
+};
+
+#if PROCESSOR_TASK
+  // Call once after InitializeProcessor(); from then on ServiceProcessor() must not be called
+  // from anywhere else. Returns false if the task could not be created.
+  bool StartProcessorTask(uint32_t periodUs = PROCESSOR_TASK_PERIOD_US);
+
+  #if !defined(ARDUINO)
+    // Native only: paced=false free-runs (no sleeping) for stress tests. Each tick advances the
+    // simulated clock by periodUs before servicing, so virtual time follows the tick either way.
+    bool StartProcessorTask(uint32_t periodUs, bool paced);
+    void StopProcessorTask(); // joins the thread
+  #endif
+
+  ProcessorTaskStats ProcessorGetTaskStats();
+#endif
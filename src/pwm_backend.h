@@ -0,0 +1,212 @@
+#pragma once
+
+// Compile-time PWM backends for the H-bridge.
+// Each backend is a policy with static Attach(pin, hz, bits) and Write(pin, duty); HBridge<> drives
+// both legs through it with a single SetBridge(in1Duty, in2Duty) primitive. The backend is chosen by
+// the preprocessor below, so every call inlines straight into ledcWrite/analogWrite with no dispatch.
+// Backends with a hardware fade engine set HAS_FADE and provide Fade(pin, from, to, ms, done) and
+// StopFade(pin); the others keep HAS_FADE false and ramps are stepped in software.
+
+#include "hal.h"
+#include "trace.h"
+#include <atomic>
+
+// Skip peripheral writes whose duty has not changed (set to 0 to always write both legs)
+#ifndef PWM_SHADOW_WRITES
+  #define PWM_SHADOW_WRITES 1
+#endif
+
+// Let the LEDC fade engine run linear ramps where it can be stopped mid-fade (set to 0 to always
+// step ramps in software)
+#ifndef PWM_HW_FADE
+  #define PWM_HW_FADE 1
+#endif
+
+typedef void (*PwmFadeDone)(); // called from interrupt context when a fade completes
+
+#if defined(CONFIG_IDF_TARGET_ESP32C6) || defined(ESP32)
+  // ESP32 and ESP32-C6 both use the pin-based v3 LEDC API
+  #include <driver/ledc.h>
+  #include <esp32-hal-periman.h>
+
+  struct LedcPwm
+  {
+    static void Attach(int pin, int hz, int bits) { ledcAttach(pin, hz, bits); }
+    static void Write(int pin, uint32_t duty) { ledcWrite(pin, duty); }
+
+    // A fade can only be handed off if a later write can interrupt it (brake, stop, reversal)
+    #if PWM_HW_FADE && defined(SOC_LEDC_SUPPORT_FADE_STOP)
+      static constexpr bool HAS_FADE = true;
+
+      static bool Fade(int pin, uint32_t from, uint32_t to, uint32_t ms, PwmFadeDone done)
+      {
+        return ledcFadeWithInterrupt(pin, from, to, (int)ms, done);
+      }
+
+      static void StopFade(int pin)
+      {
+        // The Arduino core has no fade stop, so go to IDF with the channel it assigned to the pin
+        const ledc_channel_handle_t *bus = (const ledc_channel_handle_t *)perimanGetPinBus(pin, ESP32_BUS_TYPE_LEDC);
+        if (bus)
+          ledc_fade_stop((ledc_mode_t)(bus->channel / SOC_LEDC_CHANNEL_NUM),
+                         (ledc_channel_t)(bus->channel % SOC_LEDC_CHANNEL_NUM));
+      }
+    #else
+      static constexpr bool HAS_FADE = false;
+      static bool Fade(int, uint32_t, uint32_t, uint32_t, PwmFadeDone) { return false; }
+      static void StopFade(int) {}
+    #endif
+  };
+#elif defined(ESP8266)
+  // ESP8266 uses analogWrite; frequency and range are global rather than per pin
+  struct AnalogWritePwm
+  {
+    static void Attach(int pin, int hz, int bits)
+    {
+      analogWriteFreq(hz);
+      analogWriteRange((1u << bits) - 1u);
+      pinMode(pin, OUTPUT);
+    }
+    static void Write(int pin, uint32_t duty) { analogWrite(pin, duty); }
+
+    static constexpr bool HAS_FADE = false;
+    static bool Fade(int, uint32_t, uint32_t, uint32_t, PwmFadeDone) { return false; }
+    static void StopFade(int) {}
+  };
+#elif !defined(ARDUINO)
+  // Native simulator: records into the simulated HAL (src/sim/hal_sim.cpp), which also emulates
+  // the LEDC fade engine so both ramp engines can be compared on the host
+  struct SimPwm
+  {
+    static void Attach(int pin, int hz, int bits) { hal::PwmAttach(pin, hz, bits); }
+    static void Write(int pin, uint32_t duty) { hal::PwmWrite(pin, duty); }
+
+    static constexpr bool HAS_FADE = true;
+    static bool Fade(int pin, uint32_t from, uint32_t to, uint32_t ms, PwmFadeDone done)
+    {
+      return hal::PwmFade(pin, from, to, ms, done);
+    }
+    static void StopFade(int pin) { hal::PwmFadeStop(pin); }
+  };
+#endif
+
+template <typename Backend, bool Shadow>
+class HBridge
+{
+public:
+  void Attach(int in1Pin, int in2Pin, int hz, int bits)
+  {
+    in1 = in1Pin;
+    in2 = in2Pin;
+    Backend::Attach(in1, hz, bits);
+    Backend::Attach(in2, hz, bits);
+    Backend::Write(in1, 0);
+    Backend::Write(in2, 0);
+    d1 = 0;
+    d2 = 0;
+  }
+
+  // Writes both legs back-to-back. The leg that is falling is written first, so a direction change
+  // passes through coast (both low) or brake rather than briefly driving the wrong way.
+  inline void SetBridge(uint32_t in1Duty, uint32_t in2Duty)
+  {
+    if (fadePin >= 0)
+      StopFade();
+    if (in1Duty < d1)
+    {
+      WriteLeg(in1, d1, in1Duty);
+      WriteLeg(in2, d2, in2Duty);
+    }
+    else
+    {
+      WriteLeg(in2, d2, in2Duty);
+      WriteLeg(in1, d1, in1Duty);
+    }
+  }
+
+  // Hand one leg's ramp to the backend's fade engine, driving the other leg low first. done() runs
+  // from the fade-complete interrupt; call FadeFinished() once it has been seen. Returns false (and
+  // touches nothing) when the backend has no fade engine.
+  bool FadeLeg(bool in1Leg, uint32_t from, uint32_t to, uint32_t ms, PwmFadeDone done)
+  {
+    if (!Backend::HAS_FADE)
+      return false;
+    if (fadePin >= 0)
+      StopFade();
+    if (in1Leg)
+      WriteLeg(in2, d2, 0);
+    else
+      WriteLeg(in1, d1, 0);
+    const int pin = in1Leg ? in1 : in2;
+    uint32_t &shadow = in1Leg ? d1 : d2;
+    if (!Backend::Fade(pin, from, to, ms, done))
+    {
+      shadow = UNKNOWN;
+      return false;
+    }
+    shadow = to; // where the hardware will end up
+    fadePin = pin;
+    CountWrite();
+    TRACE(TraceEvent::PWM, (in1Leg ? 1 : 2) | TRACE_PWM_FADE, 0, from);
+    return true;
+  }
+
+  // Stop a running fade wherever it has got to; that leg's duty is no longer known
+  void StopFade()
+  {
+    if (fadePin < 0)
+      return;
+    Backend::StopFade(fadePin);
+    if (fadePin == in1)
+      d1 = UNKNOWN;
+    else
+      d2 = UNKNOWN;
+    fadePin = -1;
+  }
+
+  void FadeFinished() { fadePin = -1; }
+  bool Fading() const { return fadePin >= 0; }
+
+  // Forget the shadowed duties, e.g. after something outside SetBridge drove the pins
+  void Invalidate()
+  {
+    d1 = UNKNOWN;
+    d2 = UNKNOWN;
+  }
+
+  uint32_t In1Duty() const { return d1; }
+  uint32_t In2Duty() const { return d2; }
+  // Peripheral writes actually issued; readable from any thread
+  uint32_t Writes() const { return writes.load(std::memory_order_relaxed); }
+
+private:
+  static constexpr uint32_t UNKNOWN = 0xFFFFFFFFu;
+
+  // Only the processor thread writes: a load/store pair, no read-modify-write needed
+  inline void CountWrite() { writes.store(writes.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed); }
+
+  inline void WriteLeg(int pin, uint32_t &shadow, uint32_t duty)
+  {
+    if (Shadow && shadow == duty)
+      return;
+    Backend::Write(pin, duty);
+    shadow = duty;
+    CountWrite();
+    TRACE(TraceEvent::PWM, pin == in1 ? 1 : 2, 0, duty);
+  }
+
+  int in1 = -1;
+  int in2 = -1;
+  uint32_t d1 = UNKNOWN;
+  uint32_t d2 = UNKNOWN;
+  std::atomic<uint32_t> writes{0};
+  int fadePin = -1; // leg currently owned by the fade engine
+};
+
+#if defined(CONFIG_IDF_TARGET_ESP32C6) || defined(ESP32)
+  using Bridge = HBridge<LedcPwm, PWM_SHADOW_WRITES != 0>;
+#elif defined(ESP8266)
+  using Bridge = HBridge<AnalogWritePwm, PWM_SHADOW_WRITES != 0>;
+#elif !defined(ARDUINO)
+  using Bridge = HBridge<SimPwm, PWM_SHADOW_WRITES != 0>;
+#endif
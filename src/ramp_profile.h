@@ -0,0 +1,88 @@
+#pragma once
+
+// Ramp shapes as normalized progress tables: entry i is the fraction of the duty change reached
+// at i/RAMP_PROFILE_SEGMENTS of the ramp time, in Q15 (32768 = whole change). Tables are sampled
+// with integer interpolation and scaled to the runtime duty span, so a ramp step costs a few
+// multiplies and shifts whatever the shape.
+//
+// Shapes are written for a ramp away from standstill. Ramps toward standstill play the table
+// mirrored, so the gentle end of an asymmetric shape is always the one near zero speed, where
+// gear backlash is taken up.
+
+#include <stdint.h>
+#include <stddef.h>
+
+enum class RampProfile : uint8_t {
+  LINEAR,      // constant acceleration
+  S_CURVE,     // smootherstep 6t^5-15t^4+10t^3: zero acceleration and jerk at both ends
+  EXPONENTIAL  // (e^4t - 1)/(e^4 - 1): eases off standstill, then closes quickly
+};
+constexpr size_t RAMP_PROFILE_COUNT = 3;
+
+constexpr size_t RAMP_PROFILE_SEGMENTS = 32;
+constexpr uint32_t RAMP_PROFILE_ONE = 1u << 15;
+
+namespace rampdetail
+{
+  // Generated offline from the formulas above, rounded to the nearest Q15 step
+  constexpr uint16_t TABLES[RAMP_PROFILE_COUNT][RAMP_PROFILE_SEGMENTS + 1] = {
+    { // LINEAR
+          0,  1024,  2048,  3072,  4096,  5120,  6144,  7168,  8192,  9216, 10240,
+      11264, 12288, 13312, 14336, 15360, 16384, 17408, 18432, 19456, 20480, 21504,
+      22528, 23552, 24576, 25600, 26624, 27648, 28672, 29696, 30720, 31744, 32768,
+    },
+    { // S_CURVE
+          0,    10,    73,   233,   526,   975,  1598,  2403,  3392,  4561,  5898,
+       7391,  9018, 10758, 12584, 14469, 16384, 18299, 20184, 22010, 23750, 25377,
+      26870, 28207, 29376, 30365, 31170, 31793, 32242, 32535, 32695, 32758, 32768,
+    },
+    { // EXPONENTIAL
+          0,    81,   174,   278,   397,   531,   683,   855,  1050,  1272,  1523,
+       1807,  2129,  2493,  2907,  3375,  3906,  4508,  5189,  5961,  6837,  7828,
+       8952, 10225, 11668, 13303, 15156, 17255, 19634, 22330, 25385, 28846, 32768,
+    },
+  };
+
+  // Recursive so the checks stay valid constexpr under C++11 (esp32dev default)
+  constexpr bool Monotonic(size_t p, size_t i = 1)
+  {
+    return i > RAMP_PROFILE_SEGMENTS || (TABLES[p][i - 1] <= TABLES[p][i] && Monotonic(p, i + 1));
+  }
+  constexpr bool Valid(size_t p = 0)
+  {
+    return p >= RAMP_PROFILE_COUNT ||
+           (TABLES[p][0] == 0 && TABLES[p][RAMP_PROFILE_SEGMENTS] == RAMP_PROFILE_ONE && Monotonic(p) && Valid(p + 1));
+  }
+  static_assert(Valid(), "ramp profiles must rise monotonically from 0 to RAMP_PROFILE_ONE");
+} // namespace rampdetail
+
+// Progress at posQ16 = fraction of the ramp elapsed (0..65536, 65536 = done); returns Q15 progress.
+// With mirror set the table is read as 1 - f(1 - t).
+inline uint32_t RampProfileSample(RampProfile profile, uint32_t posQ16, bool mirror)
+{
+  if (posQ16 >= (1u << 16))
+    return RAMP_PROFILE_ONE;
+  if (mirror)
+  {
+    posQ16 = (1u << 16) - posQ16;
+    if (posQ16 >= (1u << 16))
+      return 0; // 1 - f(1): the start of a mirrored ramp, past the table's last segment
+  }
+  const uint16_t *t = rampdetail::TABLES[(size_t)profile < RAMP_PROFILE_COUNT ? (size_t)profile : 0];
+  const uint32_t scaled = posQ16 * RAMP_PROFILE_SEGMENTS; // segment index in the high 16 bits
+  const uint32_t i = scaled >> 16;
+  const uint32_t frac = scaled & 0xFFFFu;
+  const uint32_t v = t[i] + (((uint32_t)(t[i + 1] - t[i]) * frac) >> 16);
+  return mirror ? RAMP_PROFILE_ONE - v : v;
+}
+
+inline const char *RampProfileName(RampProfile profile)
+{
+  switch (profile)
+  {
+    case RampProfile::LINEAR:      return "linear";
+    case RampProfile::S_CURVE:     return "s-curve";
+    case RampProfile::EXPONENTIAL: return "exponential";
+  }
+  return "?";
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+// Single-writer latest-value cell (sequence lock). The writer never waits: it bumps the sequence
+// to odd, stores the value as relaxed atomic words and bumps it back to even. Readers copy the
+// words and retry if the sequence moved underneath them, so a reader on another thread (or a
+// lower-priority task on the same core) always gets a whole value, never a torn one.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <atomic>
+#include <type_traits>
+
+template <typename T>
+class SeqLock
+{
+  static_assert(std::is_trivially_copyable<T>::value, "SeqLock values are copied as raw words");
+  static constexpr size_t WORDS = (sizeof(T) + 3) / 4;
+
+public:
+  // Writer side (one thread)
+  void Write(const T &value)
+  {
+    uint32_t w[WORDS] = {};
+    memcpy(w, &value, sizeof(T));
+    const uint32_t seq = seq_.load(std::memory_order_relaxed);
+    seq_.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t i = 0; i < WORDS; ++i)
+      words_[i].store(w[i], std::memory_order_relaxed);
+    seq_.store(seq + 2, std::memory_order_release);
+  }
+
+  // Any thread. Returns false (out untouched) if every attempt overlapped a write, or nothing has
+  // been written yet; version counts writes.
+  bool Read(T &out, uint32_t &version, int attempts = 4) const
+  {
+    while (attempts-- > 0)
+    {
+      const uint32_t seq = seq_.load(std::memory_order_acquire);
+      if (seq & 1)
+        continue;
+      uint32_t w[WORDS];
+      for (size_t i = 0; i < WORDS; ++i)
+        w[i] = words_[i].load(std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (seq_.load(std::memory_order_relaxed) != seq)
+        continue;
+      if (seq == 0)
+        return false;
+      memcpy(&out, w, sizeof(T));
+      version = seq / 2;
+      return true;
+    }
+    return false;
+  }
+
+private:
+  std::atomic<uint32_t> seq_{0};
+  std::atomic<uint32_t> words_[WORDS]; // only read once seq_ says they were written
+};
@@ -0,0 +1,213 @@
+#include "hal_sim.h"
+#include <atomic>
+#include <chrono>
+#include <thread>
+#if defined(__x86_64__) || defined(__i386__)
+  #include <x86intrin.h>
+#endif
+
+namespace
+{
+  // Advanced by whichever thread owns the processor (the simulated task in stress runs) and read
+  // by every thread that logs or posts commands
+  std::atomic<uint64_t> nowUs{0};
+  bool pinLevel[hal::sim::MAX_PINS];
+  struct PinIsr
+  {
+    hal::GpioIsr isr;
+    void *arg;
+  };
+  PinIsr pinIsr[hal::sim::MAX_PINS];
+  uint32_t pwmDuty[hal::sim::MAX_PINS];
+  uint64_t pwmWrites = 0;
+  hal::sim::PwmObserver pwmObserver = nullptr;
+  bool logEnabled = true;
+  hal::sim::LogSink logSink = nullptr;
+
+  // Emulated LEDC fade engine: one linear fade per pin, finished (and its callback fired) by AdvanceUs()
+  struct Fade
+  {
+    bool active;
+    uint32_t from;
+    uint32_t to;
+    uint64_t startUs;
+    uint64_t durationUs;
+    void (*done)();
+  };
+  Fade fades[hal::sim::MAX_PINS];
+  int activeFades = 0; // lets AdvanceUs() skip the scan on the common no-fade path
+
+  inline bool ValidPin(int pin)
+  {
+    return pin >= 0 && pin < hal::sim::MAX_PINS;
+  }
+} // namespace
+
+namespace hal
+{
+  uint32_t Millis() { return (uint32_t)(nowUs.load(std::memory_order_relaxed) / 1000u); }
+  uint32_t Micros() { return (uint32_t)nowUs.load(std::memory_order_relaxed); }
+
+  uint32_t CycleCount()
+  {
+    #if defined(__x86_64__) || defined(__i386__)
+      return (uint32_t)__rdtsc();
+    #elif defined(__aarch64__)
+      uint64_t v;
+      asm volatile("mrs %0, cntvct_el0" : "=r"(v));
+      return (uint32_t)v;
+    #else
+      return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                 std::chrono::steady_clock::now().time_since_epoch()).count();
+    #endif
+  }
+
+  // Counter rate, measured once against the host clock
+  uint32_t CpuMhz()
+  {
+    static const uint32_t mhz = []
+    {
+      const auto t0 = std::chrono::steady_clock::now();
+      const uint32_t c0 = CycleCount();
+      std::this_thread::sleep_for(std::chrono::milliseconds(20));
+      const uint32_t c1 = CycleCount();
+      const double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+      return (uint32_t)((double)(c1 - c0) / us + 0.5);
+    }();
+    return mhz;
+  }
+
+  void PwmAttach(int pin, int hz, int bits)
+  {
+    (void)hz;
+    (void)bits;
+    if (ValidPin(pin))
+      pwmDuty[pin] = 0;
+  }
+
+  void PwmWrite(int pin, uint32_t duty)
+  {
+    if (!ValidPin(pin))
+      return;
+    if (fades[pin].active)
+    {
+      fades[pin].active = false;
+      --activeFades;
+    }
+    pwmDuty[pin] = duty;
+    ++pwmWrites;
+    if (pwmObserver)
+      pwmObserver(pin, duty, nowUs);
+  }
+
+  bool PwmFade(int pin, uint32_t from, uint32_t to, uint32_t ms, void (*done)())
+  {
+    if (!ValidPin(pin))
+      return false;
+    if (!fades[pin].active)
+      ++activeFades;
+    fades[pin] = Fade{true, from, to, nowUs, (uint64_t)ms * 1000u, done};
+    pwmDuty[pin] = from;
+    ++pwmWrites;
+    if (pwmObserver)
+      pwmObserver(pin, from, nowUs);
+    return true;
+  }
+
+  void PwmFadeStop(int pin)
+  {
+    if (!ValidPin(pin) || !fades[pin].active)
+      return;
+    pwmDuty[pin] = sim::PwmDuty(pin); // freeze wherever the fade had got to
+    fades[pin].active = false;
+    --activeFades;
+  }
+
+  void GpioInputPullup(int pin)
+  {
+    if (ValidPin(pin))
+      pinLevel[pin] = true;
+  }
+
+  bool GpioRead(int pin)
+  {
+    return ValidPin(pin) ? pinLevel[pin] : true;
+  }
+
+  void GpioAttachChangeInterrupt(int pin, GpioIsr isr, void *arg)
+  {
+    if (ValidPin(pin))
+      pinIsr[pin] = PinIsr{isr, arg};
+  }
+
+  void NativeLogLine(const char *line, bool newline, uint32_t timestampMs)
+  {
+    if (logSink)
+      logSink(line, newline, timestampMs);
+    if (!logEnabled)
+      return;
+    std::printf("[%10u] %s%s", (unsigned)timestampMs, line, newline ? "\n" : "");
+  }
+
+  namespace sim
+  {
+    void Reset()
+    {
+      nowUs = 0;
+      pwmWrites = 0;
+      for (int i = 0; i < MAX_PINS; ++i)
+      {
+        pinLevel[i] = true;
+        pinIsr[i] = PinIsr{nullptr, nullptr};
+        pwmDuty[i] = 0;
+        fades[i].active = false;
+      }
+      activeFades = 0;
+    }
+
+    void AdvanceUs(uint64_t us)
+    {
+      nowUs.store(nowUs.load(std::memory_order_relaxed) + us, std::memory_order_relaxed);
+      for (int pin = 0; activeFades > 0 && pin < MAX_PINS; ++pin)
+      {
+        Fade &f = fades[pin];
+        if (!f.active || nowUs - f.startUs < f.durationUs)
+          continue;
+        f.active = false;
+        --activeFades;
+        pwmDuty[pin] = f.to;
+        if (pwmObserver)
+          pwmObserver(pin, f.to, f.startUs + f.durationUs);
+        if (f.done)
+          f.done();
+      }
+    }
+    uint64_t NowUs() { return nowUs.load(std::memory_order_relaxed); }
+
+    void SetPin(int pin, bool level)
+    {
+      if (!ValidPin(pin) || pinLevel[pin] == level)
+        return;
+      pinLevel[pin] = level;
+      if (pinIsr[pin].isr)
+        pinIsr[pin].isr(pinIsr[pin].arg); // the edge interrupt runs synchronously, at the current time
+    }
+
+    uint32_t PwmDuty(int pin)
+    {
+      if (!ValidPin(pin))
+        return 0;
+      const Fade &f = fades[pin];
+      if (!f.active)
+        return pwmDuty[pin];
+      if (nowUs - f.startUs >= f.durationUs)
+        return f.to;
+      const int64_t span = (int64_t)f.to - (int64_t)f.from;
+      return (uint32_t)((int64_t)f.from + span * (int64_t)(nowUs - f.startUs) / (int64_t)f.durationUs);
+    }
+    uint64_t PwmWriteCount() { return pwmWrites; }
+    void SetPwmObserver(PwmObserver observer) { pwmObserver = observer; }
+    void SetLogEnabled(bool enabled) { logEnabled = enabled; }
+    void SetLogSink(LogSink sink) { logSink = sink; }
+  } // namespace sim
+} // namespace hal
@@ -0,0 +1,37 @@
+#pragma once
+
+// Simulated HAL backend for the native build: virtual clock, PWM recorder and GPIO inputs.
+// Nothing here advances on its own; the host drives time with AdvanceUs()/AdvanceMs().
+
+#include "../hal.h"
+
+namespace hal
+{
+  namespace sim
+  {
+    constexpr int MAX_PINS = 64;
+
+    // Clock back to zero, every input released (high, as with a pull-up), every PWM output zeroed
+    void Reset();
+
+    void AdvanceUs(uint64_t us);
+    inline void AdvanceMs(uint64_t ms) { AdvanceUs(ms * 1000u); }
+    uint64_t NowUs(); // full 64-bit virtual time (hal::Micros() wraps like the real thing); thread-safe
+
+    // GPIO source; a level change fires the pin's edge interrupt, if attached
+    void SetPin(int pin, bool level);
+
+    // PWM sink (during an emulated fade, PwmDuty() is the interpolated duty at the current time)
+    uint32_t PwmDuty(int pin);
+    uint64_t PwmWriteCount();
+    using PwmObserver = void (*)(int pin, uint32_t duty, uint64_t nowUs);
+    void SetPwmObserver(PwmObserver observer); // called on every PwmWrite (nullptr to clear)
+
+    // Mute LOGF/LOGFLN, e.g. while running hours of cycles or benchmarks
+    void SetLogEnabled(bool enabled);
+
+    // Receives every drained log line (muted or not), e.g. to check ordering in stress runs
+    using LogSink = void (*)(const char *line, bool newline, uint32_t timestampMs);
+    void SetLogSink(LogSink sink);
+  } // namespace sim
+} // namespace hal
@@ -0,0 +1,186 @@
+#include "motor_model.h"
+#include <cmath>
+
+namespace
+{
+  constexpr float MECH_STEP_S = 100e-6f;     // mechanical integration step, at most
+  constexpr float STICTION_RAD_PER_S = 0.05f; // Coulomb friction fades in over this speed
+
+  inline float Sign(float v) { return v > 0 ? 1.0f : (v < 0 ? -1.0f : 0.0f); }
+} // namespace
+
+void MotorModel::Advance(float in1, float in2, float dtS)
+{
+  // Both legs' PWM periods start together, so the shorter pulse overlaps the longer one
+  const float both = in1 < in2 ? in1 : in2;
+  const float longer = in1 > in2 ? in1 : in2;
+  const float driveV = in1 > in2 ? p_.supplyV : -p_.supplyV;
+  limited_ = false;
+  peakA_ = std::fabs(i_);
+  carryS_ += dtS;
+  const int periods = (int)(carryS_ / periodS_ + 1e-3f);
+  carryS_ -= (float)periods * periodS_;
+  for (int n = 0; n < periods; ++n)
+  {
+    float charge = Drive(0.0f, both * periodS_, false); // both high: brake
+    charge += Drive(driveV, (longer - both) * periodS_, true);
+    charge += Coast((1.0f - longer) * periodS_);
+    Mechanics(p_.keVsPerRad * charge / periodS_, periodS_);
+  }
+}
+
+// Current through t seconds at terminal voltage v, the back-EMF held for that short interval;
+// returns the charge that flowed. With limit, drive current stops at the ILIM level.
+float MotorModel::Drive(float v, float t, bool limit)
+{
+  if (t <= 0)
+    return 0;
+  const float tau = p_.inductanceH / p_.resistanceOhm;
+  const float target = (v - p_.keVsPerRad * wm_) / p_.resistanceOhm;
+  float charge = 0;
+  if (limit && std::fabs(target) > p_.currentLimitA)
+  {
+    const float edge = Sign(target) * p_.currentLimitA;
+    float reach = 0; // time until the current gets to the limit
+    if (Sign(i_) != Sign(target) || std::fabs(i_) < p_.currentLimitA)
+      reach = tau * std::log((i_ - target) / (edge - target));
+    if (reach < t)
+    {
+      charge = target * reach + (i_ - target) * tau * (1.0f - std::exp(-reach / tau));
+      charge += edge * (t - reach);
+      i_ = edge;
+      limited_ = true;
+      peakA_ = std::fabs(i_) > peakA_ ? std::fabs(i_) : peakA_;
+      return charge;
+    }
+  }
+  const float e = std::exp(-t / tau);
+  charge = target * t + (i_ - target) * tau * (1.0f - e);
+  i_ = target + (i_ - target) * e;
+  peakA_ = std::fabs(i_) > peakA_ ? std::fabs(i_) : peakA_;
+  return charge;
+}
+
+// Both low: the bridge is high-Z. Current still flowing returns to the supply through the body
+// diodes (fast decay) until it reaches zero; with none flowing the terminals just follow the
+// back-EMF.
+float MotorModel::Coast(float t)
+{
+  if (t <= 0 || i_ == 0)
+    return 0;
+  const float tau = p_.inductanceH / p_.resistanceOhm;
+  const float v = -Sign(i_) * (p_.supplyV + 2.0f * p_.diodeV);
+  const float target = (v - p_.keVsPerRad * wm_) / p_.resistanceOhm;
+  if (Sign(target) != Sign(i_))
+  {
+    const float zero = tau * std::log((i_ - target) / -target);
+    if (zero < t)
+    {
+      const float charge = target * zero + (i_ - target) * tau * (1.0f - std::exp(-zero / tau));
+      i_ = 0;
+      return charge;
+    }
+  }
+  return Drive(v, t, false);
+}
+
+void MotorModel::Mechanics(float torque, float dtS)
+{
+  int steps = (int)std::ceil(dtS / MECH_STEP_S);
+  if (steps < 1)
+    steps = 1;
+  const float dt = dtS / (float)steps;
+  for (int s = 0; s < steps; ++s)
+  {
+    // Drivetrain: the gearbox only pushes the tank once the backlash gap has closed
+    const float half = p_.backlashRad / 2;
+    const float gap = thm_ - tht_;
+    const float pen = gap > half ? gap - half : (gap < -half ? gap + half : 0.0f);
+    float contact = 0;
+    if (pen != 0)
+    {
+      if (!engaged_)
+      {
+        lastImpact_ = std::fabs(wm_ - wt_);
+        if (lastImpact_ > maxImpact_)
+          maxImpact_ = lastImpact_;
+        engaged_ = true;
+      }
+      contact = p_.stiffnessNm * pen + p_.dampingNms * (wm_ - wt_);
+      if (Sign(contact) != Sign(pen))
+        contact = 0; // teeth push, they never pull
+    }
+    else
+    {
+      engaged_ = false;
+    }
+
+    const float friction = p_.gearCoulombNm * std::tanh(wm_ / STICTION_RAD_PER_S);
+    const float fluidDrag = p_.fluidCoupling * (wt_ - wf_);
+    wm_ += (torque - p_.motorViscous * wm_ - friction - contact) / p_.motorInertia * dt;
+    wt_ += (contact - p_.tankViscous * wt_ - fluidDrag) / p_.tankInertia * dt;
+    wf_ += fluidDrag / p_.fluidInertia * dt;
+    thm_ += wm_ * dt;
+    tht_ += wt_ * dt;
+  }
+}
+
+float MotorModel::SteadySpeed(const MotorParams &params, float duty)
+{
+  MotorModel m(params);
+  for (int ms = 0; ms < 20000; ++ms)
+    m.Advance(duty, 0, 0.001f);
+  return m.TankSpeed();
+}
+
+void MotorRunRecorder::Sample(const MotorModel &m, float dtS)
+{
+  t_ += dtS;
+  const float w = m.TankSpeed();
+  const float speed = std::fabs(w);
+  if (speed >= 0.9f * cruise_)
+    atSpeed_ += dtS;
+  slip_ += std::fabs(w - m.FluidSpeed()) * dtS;
+  if (m.PeakCurrentA() > peak_)
+    peak_ = m.PeakCurrentA();
+  if (m.CurrentLimited())
+    limit_ += dtS;
+  maxImpact_ = m.MaxImpact();
+
+  // Dead time: from dropping below half speed in one direction to passing it in the other
+  const int dir = speed >= 0.5f * cruise_ ? (w > 0 ? 1 : -1) : 0;
+  if (dir != 0)
+  {
+    if (slowing_ && dir != dir_)
+    {
+      const float ms = (float)((t_ - slowSince_) * 1000.0);
+      dead_ += ms;
+      if (ms > maxDead_)
+        maxDead_ = ms;
+      ++reversals_;
+    }
+    slowing_ = false;
+    dir_ = dir;
+  }
+  else if (dir_ != 0 && !slowing_)
+  {
+    slowing_ = true;
+    slowSince_ = t_;
+  }
+}
+
+MotorRunStats MotorRunRecorder::Finish() const
+{
+  MotorRunStats s;
+  s.seconds = (float)t_;
+  s.timeAtSpeed = t_ > 0 ? (float)(atSpeed_ / t_) : 0;
+  s.reversals = reversals_;
+  s.meanDeadMs = reversals_ ? (float)(dead_ / reversals_) : 0;
+  s.maxDeadMs = maxDead_;
+  s.peakCurrentA = peak_;
+  s.limitMs = (float)(limit_ * 1000.0);
+  s.maxImpactRadPerS = maxImpact_;
+  s.meanFluidSlip = t_ > 0 ? (float)(slip_ / t_) : 0;
+  s.safe = peak_ <= p_.safeCurrentA && maxImpact_ <= p_.safeImpactRadPerS;
+  return s;
+}
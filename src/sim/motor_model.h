@@ -0,0 +1,124 @@
+#pragma once
+
+// Host-side plant for the native build: a brushed DC gearmotor behind a DRV8871 H-bridge, turning
+// a film tank through a gearbox with backlash, with the developer inside the tank as a second
+// rotating mass. Driven by the two bridge PWM duties the processor writes, so ramp, coast and
+// reversal timings can be judged by what they do to current, speed and the drivetrain before they
+// are tried on a real tank.
+//
+// Everything is referred to the gearbox output shaft. Electrical side: every PWM period of the
+// DRV8871 inputs is split into its bridge states (both legs start high together, so: both high =
+// brake, then the longer leg alone = drive, then both low = coast) and the armature current is
+// solved exactly through each. Coast is the fast-decay, high-Z state: its current runs down to zero
+// and stops there, so at light load the current is discontinuous and speed depends on load as much
+// as on duty. Drive current is held at the ILIM regulation level. Mechanical side: motor + gearbox
+// inertia with viscous and Coulomb friction, a backlash gap with a stiff damped contact, the tank
+// with bearing drag, and the fluid coupled to the tank walls by viscous drag.
+
+#include <stdint.h>
+
+struct MotorParams
+{
+  // Supply and driver
+  float supplyV       = 12.0f;
+  float diodeV        = 0.7f;  // body diode drop; fast decay runs through two
+  float currentLimitA = 3.6f;  // DRV8871 ILIM regulation (set by its ILIM resistor)
+  float pwmHz         = 20000.0f;
+
+  // Motor (a ~100 RPM at 12 V gearmotor)
+  float resistanceOhm = 2.4f;
+  float inductanceH   = 0.0015f;
+  float keVsPerRad    = 1.05f;  // back-EMF constant = torque constant (N*m/A)
+  float motorInertia  = 0.006f; // rotor through the gear ratio plus gearbox, kg*m^2
+  float motorViscous  = 0.01f;  // N*m*s/rad
+  float gearCoulombNm = 0.08f;
+
+  // Drivetrain: backlash gap and contact between gearbox output and tank
+  float backlashRad   = 0.035f; // total play, ~2 degrees
+  float stiffnessNm   = 40.0f;  // N*m/rad once the play is taken up
+  float dampingNms    = 0.15f;
+
+  // Tank (reel, rollers) and the fluid inside it
+  float tankInertia   = 0.004f;
+  float tankViscous   = 0.004f;
+  float fluidInertia  = 0.002f;
+  float fluidCoupling = 0.01f;  // tank wall drag on the fluid, N*m*s/rad
+
+  // Limits a timing set must stay within to count as safe
+  float safeCurrentA      = 2.5f; // motor's rated peak, with margin below ILIM
+  float safeImpactRadPerS = 2.0f; // speed at which the backlash gap may close
+};
+
+class MotorModel
+{
+public:
+  explicit MotorModel(const MotorParams &params) : p_(params), periodS_(1.0f / params.pwmHz) {}
+
+  // Advances dt seconds with the bridge inputs held (duties as fractions of full scale), in whole
+  // PWM periods
+  void Advance(float in1, float in2, float dtS);
+
+  float CurrentA() const { return i_; }
+  float PeakCurrentA() const { return peakA_; } // largest |current| during the last Advance()
+  float MotorSpeed() const { return wm_; } // rad/s at the gearbox output
+  float TankSpeed() const { return wt_; }
+  float FluidSpeed() const { return wf_; }
+  bool CurrentLimited() const { return limited_; }
+  // Relative speed of the last backlash closing, and the largest so far
+  float LastImpact() const { return lastImpact_; }
+  float MaxImpact() const { return maxImpact_; }
+
+  // Tank speed the motor settles at with a constant forward duty
+  static float SteadySpeed(const MotorParams &params, float duty);
+
+private:
+  float Drive(float v, float t, bool limit);
+  float Coast(float t);
+  void Mechanics(float torque, float dt);
+
+  MotorParams p_;
+  float periodS_;
+  float carryS_ = 0; // time not yet covered by a whole period
+  float i_ = 0;
+  float peakA_ = 0;
+  float wm_ = 0, wt_ = 0, wf_ = 0;
+  float thm_ = 0, tht_ = 0;
+  bool engaged_ = false;
+  bool limited_ = false;
+  float lastImpact_ = 0;
+  float maxImpact_ = 0;
+};
+
+// What one run of the cycle did: how long the tank spends at speed, how long each reversal leaves
+// it stopped, and what that cost in current and drivetrain shock
+struct MotorRunStats
+{
+  float seconds;
+  float timeAtSpeed;    // fraction of the run at >= 90% of cruise speed
+  uint32_t reversals;
+  float meanDeadMs;     // per reversal: below 50% of cruise speed, from leaving one direction until
+  float maxDeadMs;      // reaching it in the other
+  float peakCurrentA;
+  float limitMs;        // time in ILIM regulation
+  float maxImpactRadPerS;
+  float meanFluidSlip;  // mean |tank - fluid| speed, rad/s: the agitation the developer sees
+  bool safe;
+};
+
+class MotorRunRecorder
+{
+public:
+  MotorRunRecorder(const MotorParams &params, float cruiseSpeed) : p_(params), cruise_(cruiseSpeed) {}
+  void Sample(const MotorModel &m, float dtS);
+  MotorRunStats Finish() const;
+
+private:
+  MotorParams p_;
+  float cruise_;
+  double t_ = 0, atSpeed_ = 0, slip_ = 0, limit_ = 0, dead_ = 0;
+  float peak_ = 0, maxDead_ = 0, maxImpact_ = 0;
+  uint32_t reversals_ = 0;
+  int dir_ = 0;          // direction last seen at speed
+  bool slowing_ = false; // left dir_'s speed band; dead time running
+  double slowSince_ = 0;
+};
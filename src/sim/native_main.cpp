@@ -0,0 +1,1356 @@
+// Native simulator entry point for the [env:native] build:
+//   pio run -e native && .pio/build/native/program <command> [args]
+//
+//   sim [hours] [tickUs]   run agitation cycles on the virtual clock and report cycle timing
+//   bench [calls]          measure ServiceProcessor(), LOGFLN, TRACE, command parse and JSON payload cost
+//                          (time, bytes and heap allocations per message) on the host
+//   rampcheck              compare hardware-fade and software ramp trajectories, and check every
+//                          profile's endpoints plain and mirrored (exit 1 on mismatch)
+//   metrics [seconds]      run cycles on the virtual clock, then print /api/metrics and the WS form
+//   status [seconds]       run cycles on the virtual clock with two status channel subscribers and
+//                          report frames, bytes and state staleness per client (exit 1 on mismatch)
+//   outbox [seconds]       stream logs and status to a fast, a slow and a stalling WebSocket client
+//                          through the outbox and check drops, latest state and disconnects (exit 1;
+//                          at least 5 s, run on until the stalling client can have been disconnected)
+//   telemetry [seconds]    stream binary duty telemetry to a 200 Hz and a 50 Hz client and check
+//                          spacing and duties against the PWM outputs (exit 1 on mismatch)
+//   trace [seconds] [file] run cycles with a status client and a mid-run command, then write the
+//                          event trace as Chrome Trace Event JSON (default trace.json) for Perfetto
+//   motor [seconds] [volts] drive the DC gearmotor / tank model (motor_model.h) with the current
+//                          timings and report dead time, current, time at speed and backlash shock
+//   sweep [seconds] [volts] the same over a grid of ramp up/down and coast times, fastest safe first
+//   stress [seconds]       run the processor task against concurrent network/console producers
+//                          and check queue, log, bridge and status snapshot invariants (exit 1 on failure)
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <pthread.h>
+#include <sched.h>
+#if defined(__x86_64__) || defined(__i386__)
+  #include <x86intrin.h>
+#endif
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "../commands.h"
+#include "../metrics.h"
+#include "../platform_config.h"
+#include "../processor_task.h"
+#include "../ramp_profile.h"
+#include "../status_channel.h"
+#include "../status_json.h"
+#include "../telemetry.h"
+#include "../trace.h"
+#include "../ws_outbox.h"
+#include "hal_sim.h"
+#include "motor_model.h"
+
+// Counts heap allocations (operator new) for the payload benchmarks
+static std::atomic<uint64_t> heapAllocs{0};
+
+void *operator new(size_t size)
+{
+  heapAllocs.fetch_add(1, std::memory_order_relaxed);
+  if (void *p = std::malloc(size ? size : 1))
+    return p;
+  throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, size_t) noexcept { std::free(p); }
+
+namespace
+{
+  ProcessorConfig cfg;
+
+  // Forward drive starts observed on the PWM sink, used to measure cycle period and drift
+  struct CycleTrace
+  {
+    bool lastForward{false};
+    bool driving{false};
+    uint64_t firstFwdUs{0};
+    uint64_t lastFwdUs{0};
+    uint32_t fwdStarts{0};
+    int64_t maxDriftUs{0};
+  };
+  CycleTrace trace;
+
+  void OnPwmWrite(int pin, uint32_t duty, uint64_t nowUs)
+  {
+    if (duty == 0 || duty >= (1u << cfg.pwmBits) - 1u)
+      return; // coast/brake writes are not drive starts
+    const bool forward = (pin == cfg.pins.in1);
+    if (trace.driving && forward == trace.lastForward)
+      return;
+    trace.driving = true;
+    trace.lastForward = forward;
+    if (!forward)
+      return;
+
+    // Anchor on the first start after a reversal; the start from standstill has no coast in front of it
+    if (trace.fwdStarts == 1)
+      trace.firstFwdUs = nowUs;
+    if (trace.fwdStarts > 1)
+    {
+      const uint64_t periodUs = (uint64_t)(cfg.t.forwardRunMs + cfg.t.reverseRunMs) * 1000u;
+      const int64_t drift = (int64_t)(nowUs - trace.firstFwdUs) - (int64_t)((trace.fwdStarts - 1) * periodUs);
+      if (llabs(drift) > llabs(trace.maxDriftUs))
+        trace.maxDriftUs = drift;
+    }
+    trace.lastFwdUs = nowUs;
+    ++trace.fwdStarts;
+  }
+
+  void Boot()
+  {
+    hal::sim::Reset();
+    cfg = getPlatformConfig();
+    InitializeProcessor(cfg);
+  }
+
+  // Holds the start button low long enough to pass the debounce, servicing the processor meanwhile
+  void PressButton(uint32_t tickUs)
+  {
+    hal::sim::SetPin(cfg.pins.btnStart, false);
+    for (uint32_t t = 0; t < 100000; t += tickUs)
+    {
+      hal::sim::AdvanceUs(tickUs);
+      ServiceProcessor();
+      LogDrain();
+    }
+    hal::sim::SetPin(cfg.pins.btnStart, true);
+  }
+
+  int RunSim(double hours, uint32_t tickUs)
+  {
+    Boot();
+    hal::sim::SetLogEnabled(false);
+    hal::sim::SetPwmObserver(OnPwmWrite);
+
+    const auto wall0 = std::chrono::steady_clock::now();
+    PressButton(tickUs);
+    const uint64_t endUs = hal::sim::NowUs() + (uint64_t)(hours * 3600.0 * 1e6);
+    uint64_t calls = 0;
+    while (hal::sim::NowUs() < endUs)
+    {
+      hal::sim::AdvanceUs(tickUs);
+      ServiceProcessor();
+      LogDrain();
+      ++calls;
+    }
+    const double wallMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - wall0).count();
+
+    hal::sim::SetPwmObserver(nullptr);
+    const ProcessorSchedulerStats st = ProcessorGetSchedulerStats();
+    std::printf("Simulated %.2f h (tick %u us) in %.1f ms wall, %llu ServiceProcessor calls\n",
+                hours, (unsigned)tickUs, wallMs, (unsigned long long)calls);
+    std::printf("Forward starts: %u, PWM writes: %llu\n", (unsigned)trace.fwdStarts,
+                (unsigned long long)hal::sim::PwmWriteCount());
+    std::printf("Cycle drift vs forwardRunMs+reverseRunMs: max %lld us\n", (long long)trace.maxDriftUs);
+    std::printf("Reversals: %u, resyncs: %u, lateness min/mean/max: %u/%u/%u us\n",
+                (unsigned)st.transitions, (unsigned)st.resyncs, (unsigned)st.minLateUs,
+                (unsigned)st.meanLateUs, (unsigned)st.maxLateUs);
+
+    hal::sim::SetLogEnabled(true);
+    ProcessorCommandPrintState();
+    LogDrain(LOG_RING_SIZE);
+    return 0;
+  }
+
+  // Host cycle counter (TSC on x86, virtual counter on AArch64); 0 where neither is available
+  inline uint64_t CycleCount()
+  {
+    #if defined(__x86_64__) || defined(__i386__)
+      return __rdtsc();
+    #elif defined(__aarch64__)
+      uint64_t v;
+      asm volatile("mrs %0, cntvct_el0" : "=r"(v));
+      return v;
+    #else
+      return 0;
+    #endif
+  }
+
+  struct CallCost
+  {
+    double ns;
+    double cycles;
+  };
+
+  // Cost of one ServiceProcessor() call with the virtual clock stepping stepUs per call
+  CallCost MeasureCallCost(uint64_t calls, uint32_t stepUs)
+  {
+    const auto t0 = std::chrono::steady_clock::now();
+    const uint64_t c0 = CycleCount();
+    for (uint64_t i = 0; i < calls; ++i)
+    {
+      hal::sim::AdvanceUs(stepUs);
+      ServiceProcessor();
+    }
+    const uint64_t c1 = CycleCount();
+    const auto t1 = std::chrono::steady_clock::now();
+    return CallCost{std::chrono::duration<double, std::nano>(t1 - t0).count() / (double)calls,
+                    (double)(c1 - c0) / (double)calls};
+  }
+
+  // Producer-side cost of one LOGFLN (capture only; the ring is drained outside the timed region)
+  double MeasureLogCaptureNs(uint64_t records)
+  {
+    double totalNs = 0;
+    uint64_t done = 0;
+    while (done < records)
+    {
+      const uint64_t batch = LOG_RING_SIZE;
+      const auto t0 = std::chrono::steady_clock::now();
+      for (uint64_t i = 0; i < batch; ++i)
+        LOGFLN("RampForward: target=%d, rampTime=%d, phase=%s", (int)i, 15, "RUN_FWD");
+      totalNs += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+      LogDrain(LOG_RING_SIZE);
+      done += batch;
+    }
+    return totalNs / (double)done;
+  }
+
+  // Producer-side cost of one TRACE() event (clock read included)
+  CallCost MeasureTraceCost(uint64_t events)
+  {
+    const auto t0 = std::chrono::steady_clock::now();
+    const uint64_t c0 = CycleCount();
+    for (uint64_t i = 0; i < events; ++i)
+      TRACE(TraceEvent::PWM, 1, 0, (uint32_t)i);
+    const uint64_t c1 = CycleCount();
+    const auto t1 = std::chrono::steady_clock::now();
+    return CallCost{std::chrono::duration<double, std::nano>(t1 - t0).count() / (double)events,
+                    (double)(c1 - c0) / (double)events};
+  }
+
+  // Command table lookup + in-place argument parse (handlers are not run)
+  double MeasureParseNs(const char *text, uint64_t iterations)
+  {
+    const size_t len = std::strlen(text);
+    ParsedCommand parsed;
+    uint32_t ok = 0;
+    const auto t0 = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+      ok += ParseCommand(text, len, parsed) == CommandResult::OK;
+      asm volatile("" : : "r"(&parsed) : "memory");
+    }
+    const auto t1 = std::chrono::steady_clock::now();
+    if (ok != 0 && ok != (uint32_t)iterations)
+      std::printf("  (inconsistent parse results for \"%s\")\n", text);
+    return std::chrono::duration<double, std::nano>(t1 - t0).count() / (double)iterations;
+  }
+
+  struct PayloadCost
+  {
+    double ns;
+    double allocs;
+    size_t bytes;
+  };
+
+  // build(buf, cap) returns the payload length; the buffer is reused across iterations
+  template <typename Build>
+  PayloadCost MeasurePayload(uint64_t iterations, Build build)
+  {
+    static char buf[2048];
+    size_t bytes = 0;
+    const uint64_t a0 = heapAllocs.load(std::memory_order_relaxed);
+    const auto t0 = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+      bytes = build(buf, sizeof(buf), (uint32_t)i);
+      asm volatile("" : : "r"(buf) : "memory");
+    }
+    const auto t1 = std::chrono::steady_clock::now();
+    const uint64_t a1 = heapAllocs.load(std::memory_order_relaxed);
+    return PayloadCost{std::chrono::duration<double, std::nano>(t1 - t0).count() / (double)iterations,
+                       (double)(a1 - a0) / (double)iterations, bytes};
+  }
+
+  const char BENCH_LOG_LINE[] = "RampForward: target=\"72.3%\", rampTime=300\tphase=RUN_FWD";
+
+  // The String-concatenation builder the log payload used before JsonWriter, for comparison
+  size_t BuildLogConcat(char *out, size_t cap, uint32_t ts)
+  {
+    std::string escaped;
+    escaped.reserve(sizeof(BENCH_LOG_LINE) + 8);
+    for (const char *p = BENCH_LOG_LINE; *p; ++p)
+    {
+      switch (*p)
+      {
+        case '\\': escaped += "\\\\"; break;
+        case '"':  escaped += "\\\""; break;
+        case '\n': escaped += "\\n"; break;
+        case '\r': escaped += "\\r"; break;
+        case '\t': escaped += "\\t"; break;
+        default: escaped += *p; break;
+      }
+    }
+    std::string payload = "{\"type\":\"log\",\"timestamp\":";
+    payload += std::to_string(ts);
+    payload += ",\"message\":\"";
+    payload += escaped;
+    payload += "\"}";
+    const size_t n = payload.size() < cap ? payload.size() : cap - 1;
+    std::memcpy(out, payload.data(), n);
+    return n;
+  }
+
+  void PrintPayload(const char *name, const PayloadCost &c)
+  {
+    std::printf("  %-26s %6.1f ns %5.2f allocs %5zu bytes\n", name, c.ns, c.allocs, c.bytes);
+  }
+
+  int RunBench(uint64_t calls)
+  {
+    Boot();
+    hal::sim::SetLogEnabled(false);
+    LogDrain(LOG_RING_SIZE);
+
+    const CallCost idle = MeasureCallCost(calls, 1);
+    PressButton(1000);
+    const CallCost run = MeasureCallCost(calls, 1); // cruising inside a 10 s phase
+    // Coarse steps across many phases so ramps, coasts and reversals are all exercised
+    const CallCost cycle = MeasureCallCost(calls, 997);
+    LogDrain(LOG_RING_SIZE);
+    const double logNs = MeasureLogCaptureNs(calls / 10 + 1);
+    const CallCost trace = MeasureTraceCost(calls / 10 + 1);
+    static const char *const parseCases[] = {"f", "stop_coast", "set_cruise=65.5", "history_since=123456", "set fwd 8000", "bogus_command"};
+
+    hal::sim::SetLogEnabled(true);
+    std::printf("ServiceProcessor() cost over %llu calls:\n", (unsigned long long)calls);
+    std::printf("  idle:                %6.1f ns/call %7.1f cycles/call\n", idle.ns, idle.cycles);
+    std::printf("  cruising:            %6.1f ns/call %7.1f cycles/call\n", run.ns, run.cycles);
+    std::printf("  cycling (~1ms/call): %6.1f ns/call %7.1f cycles/call\n", cycle.ns, cycle.cycles);
+    std::printf("LOGFLN capture: %.1f ns/record\n", logNs);
+    std::printf("TRACE event:    %.1f ns/event %.1f cycles/event\n", trace.ns, trace.cycles);
+    std::printf("Command parse:\n");
+    for (const char *text : parseCases)
+      std::printf("  %-22s %6.1f ns\n", text, MeasureParseNs(text, calls / 10 + 1));
+
+    const uint64_t messages = calls / 10 + 1;
+    std::printf("JSON payloads (per message):\n");
+    PrintPayload("log (String concat, old)", MeasurePayload(messages, BuildLogConcat));
+    PrintPayload("log", MeasurePayload(messages, [](char *out, size_t cap, uint32_t ts) -> size_t
+    {
+      JsonWriter w(out, cap);
+      WriteLogJson(w, ts, BENCH_LOG_LINE, sizeof(BENCH_LOG_LINE) - 1);
+      return w.Length();
+    }));
+    PrintPayload("processor status", MeasurePayload(messages, [](char *out, size_t cap, uint32_t) -> size_t
+    {
+      JsonWriter w(out, cap);
+      w.BeginObject();
+      WriteProcessorStatusJson(w);
+      w.EndObject();
+      return w.Length();
+    }));
+    PrintPayload("boot timeline", MeasurePayload(messages, [](char *out, size_t cap, uint32_t) -> size_t
+    {
+      JsonWriter w(out, cap);
+      WriteBootJson(w);
+      return w.Length();
+    }));
+    PrintPayload("metrics", MeasurePayload(messages, [](char *out, size_t cap, uint32_t) -> size_t
+    { return MetricsFormatCompact(out, cap); }));
+    return 0;
+  }
+
+  // One ramp from fromPct to toPct on IN1 with the chosen engine, sampled every virtual millisecond
+  std::vector<uint32_t> TraceRamp(bool hwFade, uint16_t rampMs, float fromPct, float toPct)
+  {
+    Boot();
+    cfg.hwFade = hwFade;
+    cfg.t.rampUpMs = rampMs;
+    cfg.cruisePct = fromPct;
+    InitializeProcessor(cfg);
+    if (fromPct > 0.0f)
+    {
+      ProcessorCommandManualForward();
+      for (uint32_t t = 0; t < rampMs + 100u; ++t)
+      {
+        hal::sim::AdvanceMs(1);
+        ServiceProcessor();
+      }
+    }
+
+    ProcessorCommandSetCruise(toPct);
+    ProcessorCommandManualForward();
+    std::vector<uint32_t> samples;
+    for (uint32_t t = 0; t < rampMs + 20u; ++t)
+    {
+      hal::sim::AdvanceMs(1);
+      ServiceProcessor();
+      samples.push_back(hal::sim::PwmDuty(cfg.pins.in1));
+    }
+    LogDrain(LOG_RING_SIZE);
+    return samples;
+  }
+
+  size_t FirstIndexOf(const std::vector<uint32_t> &v, uint32_t value)
+  {
+    for (size_t i = 0; i < v.size(); ++i)
+      if (v[i] == value)
+        return i;
+    return v.size();
+  }
+
+  int RunRampCheck()
+  {
+    struct Case
+    {
+      uint16_t rampMs;
+      float fromPct;
+      float toPct;
+    };
+    static const Case cases[] = {
+      {100, 0.0f, 72.3f}, {300, 0.0f, 72.3f}, {300, 72.3f, 20.0f}, {1000, 20.0f, 100.0f}, {2550, 100.0f, 0.0f},
+    };
+
+    hal::sim::SetLogEnabled(false);
+    int failures = 0;
+    std::printf("ramp      from->to   done sw/hw (ms)  max |sw-hw| at steps / anywhere\n");
+    for (const Case &c : cases)
+    {
+      const std::vector<uint32_t> sw = TraceRamp(false, c.rampMs, c.fromPct, c.toPct);
+      const std::vector<uint32_t> hw = TraceRamp(true, c.rampMs, c.fromPct, c.toPct);
+      const uint32_t target = sw.back();
+
+      uint32_t atSteps = 0;
+      uint32_t anywhere = 0;
+      for (size_t i = 0; i < sw.size(); ++i)
+      {
+        const uint32_t diff = sw[i] > hw[i] ? sw[i] - hw[i] : hw[i] - sw[i];
+        if (diff > anywhere)
+          anywhere = diff;
+        if ((i + 1) % 10 == 0 && diff > atSteps) // software step boundaries (RAMP_STEP_MS)
+          atSteps = diff;
+      }
+      const size_t doneSw = FirstIndexOf(sw, target) + 1;
+      const size_t doneHw = FirstIndexOf(hw, target) + 1;
+      const bool ok = atSteps <= 1 && doneSw == doneHw && hw.back() == target;
+      failures += ok ? 0 : 1;
+      std::printf("%5u ms  %5.1f->%-5.1f  %5u/%-5u       %4u / %-4u  %s\n", (unsigned)c.rampMs, c.fromPct, c.toPct,
+                  (unsigned)doneSw, (unsigned)doneHw, (unsigned)atSteps, (unsigned)anywhere, ok ? "ok" : "MISMATCH");
+    }
+
+    // Profile endpoints, plain and mirrored: 0 at the start, RAMP_PROFILE_ONE once done
+    for (size_t p = 0; p < RAMP_PROFILE_COUNT; ++p)
+      for (int mirror = 0; mirror < 2; ++mirror)
+      {
+        const uint32_t start = RampProfileSample((RampProfile)p, 0, mirror != 0);
+        const uint32_t done = RampProfileSample((RampProfile)p, 1u << 16, mirror != 0);
+        const bool ok = start == 0 && done == RAMP_PROFILE_ONE;
+        failures += ok ? 0 : 1;
+        std::printf("%-11s %-8s  f(0)=%-5u f(1)=%-5u  %s\n", RampProfileName((RampProfile)p), mirror ? "mirrored" : "",
+                    (unsigned)start, (unsigned)done, ok ? "ok" : "MISMATCH");
+      }
+    hal::sim::SetLogEnabled(true);
+    return failures ? 1 : 0;
+  }
+
+  // stress: the processor task free-runs on its own thread while a "network" thread and the main
+  // thread post commands and log as fast as they can, exercising the SPSC queues and log rings
+  struct StressState
+  {
+    std::atomic<bool> stop{false};
+    std::atomic<uint32_t> bothDriven{0}; // PWM writes leaving both legs partly on (neither coast nor brake)
+    uint32_t in1Duty = 0;                // PWM observer runs on the processor thread only
+    uint32_t in2Duty = 0;
+    uint32_t lastSeq[2] = {0, 0};        // log sink runs from LogDrain() on the main thread only
+    uint32_t seen[2] = {0, 0};
+    uint32_t outOfOrder = 0;
+  };
+  StressState stress;
+
+  void OnStressPwm(int pin, uint32_t duty, uint64_t)
+  {
+    if (pin == cfg.pins.in1)
+      stress.in1Duty = duty;
+    else if (pin == cfg.pins.in2)
+      stress.in2Duty = duty;
+    const uint32_t maxd = (1u << cfg.pwmBits) - 1u;
+    if (stress.in1Duty && stress.in2Duty && !(stress.in1Duty == maxd && stress.in2Duty == maxd))
+      stress.bothDriven.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void OnStressLog(const char *line, bool, uint32_t)
+  {
+    char who[8];
+    unsigned seq;
+    if (std::sscanf(line, "stress %7s seq=%u", who, &seq) != 2)
+      return;
+    const int i = std::strcmp(who, "net") == 0 ? 1 : 0;
+    if (stress.seen[i] && seq <= stress.lastSeq[i])
+      ++stress.outOfOrder;
+    stress.lastSeq[i] = seq;
+    ++stress.seen[i];
+  }
+
+  // Random motor command; timings are left alone so the cycle keeps moving
+  void PostRandom(uint32_t &rng, CommandSource src, uint32_t &accepted)
+  {
+    static const ProcessorCommand cmds[] = {
+        ProcessorCommand::AUTO_START, ProcessorCommand::AUTO_START, ProcessorCommand::MANUAL_FWD,
+        ProcessorCommand::MANUAL_REV, ProcessorCommand::COAST_STOP, ProcessorCommand::BRAKE_STOP,
+        ProcessorCommand::SET_CRUISE, ProcessorCommand::SET_RAMP_PROFILE, ProcessorCommand::ALL_OFF};
+    rng = rng * 1664525u + 1013904223u;
+    const ProcessorCommand cmd = cmds[(rng >> 16) % (sizeof(cmds) / sizeof(cmds[0]))];
+    const float arg = cmd == ProcessorCommand::SET_CRUISE ? 20.0f + (float)((rng >> 8) % 81)
+                      : cmd == ProcessorCommand::SET_RAMP_PROFILE ? (float)((rng >> 4) % 3)
+                                                                  : 0.0f;
+    accepted += ProcessorPostCommand(cmd, arg, src) ? 1 : 0;
+  }
+
+  struct NetworkThread
+  {
+    uint32_t accepted = 0;
+    uint32_t logged = 0;
+    uint32_t statusReads = 0;
+    uint32_t statusBad = 0; // snapshot that could not have been published as a whole
+
+    void CheckStatus(uint32_t &lastVersion)
+    {
+      ProcessorStatus st;
+      uint32_t version;
+      if (!ProcessorGetStatus(st, version))
+        return;
+      ++statusReads;
+      if (version < lastVersion || st.duty > st.dutyMax || st.dutyMax != (1u << cfg.pwmBits) - 1u ||
+          (st.running && st.phase == ProcessorPhase::IDLE))
+        ++statusBad;
+      lastVersion = version;
+    }
+
+    static void *Main(void *self)
+    {
+      NetworkThread &t = *(NetworkThread *)self;
+      LogBindProducer(LogProducer::NETWORK);
+      uint32_t rng = 0x1234567u;
+      uint32_t lastVersion = 0;
+      while (!stress.stop.load(std::memory_order_relaxed))
+      {
+        PostRandom(rng, CommandSource::NETWORK, t.accepted);
+        LOGFLN("stress net seq=%u", (unsigned)++t.logged);
+        t.CheckStatus(lastVersion);
+        sched_yield();
+      }
+      return nullptr;
+    }
+  };
+
+  int RunStress(double seconds)
+  {
+    Boot();
+    hal::sim::SetLogEnabled(false);
+    hal::sim::SetLogSink(OnStressLog);
+    hal::sim::SetPwmObserver(OnStressPwm);
+    LogDrain(LOG_RING_SIZE);
+
+    // 1 ms virtual ticks, free-running: virtual time races ahead so many phases and ramps are covered
+    if (!StartProcessorTask(1000, false))
+    {
+      std::printf("could not start the processor task\n");
+      return 1;
+    }
+    NetworkThread net;
+    pthread_t netThread;
+    if (pthread_create(&netThread, nullptr, NetworkThread::Main, &net) != 0)
+    {
+      StopProcessorTask();
+      std::printf("could not start the network thread\n");
+      return 1;
+    }
+
+    uint32_t consoleAccepted = 0;
+    uint32_t mainLogged = 0;
+    uint32_t rng = 0x89abcdefu;
+    const auto wall0 = std::chrono::steady_clock::now();
+    const auto until = wall0 + std::chrono::duration<double>(seconds);
+    while (std::chrono::steady_clock::now() < until)
+    {
+      PostRandom(rng, CommandSource::CONSOLE, consoleAccepted);
+      LOGFLN("stress main seq=%u", (unsigned)++mainLogged);
+      LogDrain(LOG_RING_SIZE);
+      sched_yield();
+    }
+
+    stress.stop.store(true, std::memory_order_relaxed);
+    pthread_join(netThread, nullptr);
+    StopProcessorTask();
+    ServiceProcessor(); // run whatever is still queued
+    while (LogGetStats().pending)
+      LogDrain(LOG_RING_SIZE);
+    hal::sim::SetPwmObserver(nullptr);
+    hal::sim::SetLogSink(nullptr);
+
+    const ProcessorCommandStats cs = ProcessorGetCommandStats();
+    const ProcessorTaskStats ts = ProcessorGetTaskStats();
+    const uint32_t netDropped = logDropped[(size_t)LogProducer::NETWORK].load();
+    const uint32_t mainDropped = logDropped[(size_t)LogProducer::MAIN].load();
+    const uint32_t accepted = net.accepted + consoleAccepted;
+
+    bool ok = true;
+    auto check = [&ok](bool cond, const char *what) {
+      std::printf("  %-44s %s\n", what, cond ? "ok" : "FAIL");
+      ok = ok && cond;
+    };
+    std::printf("Stressed %.1f s wall, %.1f s virtual, %u processor ticks\n", seconds,
+                (double)hal::sim::NowUs() / 1e6, (unsigned)ts.ticks);
+    std::printf("Commands: %u accepted (%u network, %u console), %u rejected, %u executed\n",
+                (unsigned)accepted, (unsigned)net.accepted, (unsigned)consoleAccepted, (unsigned)cs.rejected,
+                (unsigned)cs.executed);
+    std::printf("Log lines: network %u sent/%u seen/%u dropped, main %u sent/%u seen/%u dropped\n",
+                (unsigned)net.logged, (unsigned)stress.seen[1], (unsigned)netDropped, (unsigned)mainLogged,
+                (unsigned)stress.seen[0], (unsigned)mainDropped);
+    check(cs.posted == accepted && cs.executed == accepted, "every accepted command executed once");
+    check(stress.seen[1] + netDropped == net.logged, "network log lines delivered or counted dropped");
+    check(stress.seen[0] + mainDropped == mainLogged, "main log lines delivered or counted dropped");
+    check(stress.outOfOrder == 0, "per-producer log order preserved");
+    check(stress.bothDriven.load() == 0, "bridge never drives both legs outside brake");
+    check(net.statusReads > 0 && net.statusBad == 0, "status snapshots read whole and in order");
+
+    hal::sim::SetLogEnabled(true);
+    return ok ? 0 : 1;
+  }
+
+  // Prints the same exposition /api/metrics serves, pulled through a small buffer like a chunked response
+  int RunMetrics(double seconds)
+  {
+    Boot();
+    hal::sim::SetLogEnabled(false);
+    PressButton(1000);
+    const uint64_t endUs = hal::sim::NowUs() + (uint64_t)(seconds * 1e6);
+    while (hal::sim::NowUs() < endUs)
+    {
+      hal::sim::AdvanceUs(1000);
+      ServiceProcessor();
+      LogDrain();
+    }
+    hal::sim::SetLogEnabled(true);
+
+    MetricsPrometheusWriter writer;
+    char chunk[100];
+    size_t n;
+    while ((n = writer.Fill(chunk, sizeof(chunk))) > 0)
+      std::fwrite(chunk, 1, n, stdout);
+    char compact[448];
+    n = MetricsFormatCompact(compact, sizeof(compact));
+    std::printf("\n%.*s\n", (int)n, compact);
+    return 0;
+  }
+
+  // Status channel subscribers: each frame is "delivered" at once; the phase a client last heard
+  // about is tracked to measure how long it lags the processor
+  struct StatusClient
+  {
+    const char *label;
+    uint32_t frames;
+    uint64_t bytes;
+    uint64_t fullBytes; // what full (non-delta) state frames would have cost
+    char phase[16];
+    uint32_t staleSinceMs; // UINT32_MAX: client is current
+    uint32_t maxStaleMs;
+  };
+  StatusClient statusClients[2];
+  const char *currentPhase = "";
+
+  bool OnStatusFrame(uint32_t clientId, const char *json, size_t len)
+  {
+    StatusClient &c = statusClients[clientId - 1];
+    ++c.frames;
+    c.bytes += len;
+    if (std::strncmp(json, "{\"type\":\"state\"", 15) == 0)
+    {
+      ProcessorStatus st;
+      uint32_t version;
+      ProcessorGetStatus(st, version);
+      char full[384];
+      JsonWriter w(full, sizeof(full));
+      w.BeginObject().Field("type", "state");
+      WriteMotionJson(w, st);
+      WriteConfigJson(w, st);
+      w.EndObject();
+      c.fullBytes += w.Length();
+    }
+    else
+    {
+      c.fullBytes += len;
+    }
+    if (const char *p = std::strstr(json, "\"phase\":\""))
+    {
+      p += 9;
+      const char *end = std::strchr(p, '"');
+      std::snprintf(c.phase, sizeof(c.phase), "%.*s", (int)(end - p), p);
+    }
+    return true;
+  }
+
+  void WriteSimSystem(JsonWriter &w)
+  {
+    w.Key("uptime").Uint(hal::Millis());
+  }
+
+  int RunStatus(double seconds)
+  {
+    Boot();
+    hal::sim::SetLogEnabled(false);
+    statusClients[0] = StatusClient{"default", 0, 0, 0, "", UINT32_MAX, 0};
+    statusClients[1] = StatusClient{"motion @ 2 Hz", 0, 0, 0, "", UINT32_MAX, 0};
+    StatusAddClient(1, hal::Millis());
+    StatusAddClient(2, hal::Millis());
+    StatusSubscribe(2, STATUS_ALL_TOPICS, false, 0);
+    StatusSubscribe(2, 1u << (uint8_t)StatusTopic::MOTION, true, 500);
+
+    PressButton(1000);
+    const uint64_t startUs = hal::sim::NowUs();
+    const uint64_t endUs = startUs + (uint64_t)(seconds * 1e6);
+    bool tuned = false;
+    bool stopped = false;
+    while (hal::sim::NowUs() < endUs + 1000000)
+    {
+      hal::sim::AdvanceUs(1000);
+      ServiceProcessor();
+      LogDrain();
+      if (!tuned && hal::sim::NowUs() - startUs > (endUs - startUs) / 2)
+      {
+        // Config changes mid-run go out as config deltas
+        ProcessorPostCommand(ProcessorCommand::SET_CRUISE, 80.0f, CommandSource::CONSOLE);
+        ProcessorPostCommand(ProcessorCommand::SET_COAST_MS, 400.0f, CommandSource::CONSOLE);
+        tuned = true;
+      }
+      if (!stopped && hal::sim::NowUs() >= endUs)
+      {
+        // Then stop and give every client a second to catch up with the final state
+        ProcessorPostCommand(ProcessorCommand::BRAKE_STOP, 0.0f, CommandSource::CONSOLE);
+        stopped = true;
+      }
+
+      ProcessorStatus st;
+      uint32_t version;
+      if (ProcessorGetStatus(st, version))
+        currentPhase = ProcessorPhaseName(st.phase);
+      const uint32_t nowMs = hal::Millis();
+      for (StatusClient &c : statusClients)
+        if (std::strcmp(c.phase, currentPhase) != 0 && c.staleSinceMs == UINT32_MAX)
+          c.staleSinceMs = nowMs;
+
+      StatusPublish(nowMs, WriteSimSystem, OnStatusFrame);
+
+      for (StatusClient &c : statusClients)
+      {
+        if (c.staleSinceMs != UINT32_MAX && std::strcmp(c.phase, currentPhase) == 0)
+        {
+          if (nowMs - c.staleSinceMs > c.maxStaleMs)
+            c.maxStaleMs = nowMs - c.staleSinceMs;
+          c.staleSinceMs = UINT32_MAX;
+        }
+      }
+    }
+    hal::sim::SetLogEnabled(true);
+
+    int failures = 0;
+    std::printf("client          frames   frames/s    bytes  bytes/s  (full frames: bytes)  max phase lag  last phase\n");
+    for (const StatusClient &c : statusClients)
+    {
+      const bool ok = std::strcmp(c.phase, currentPhase) == 0;
+      failures += !ok;
+      std::printf("%-14s %7u %10.1f %8llu %8.0f  %20llu  %10u ms  %s %s\n", c.label, (unsigned)c.frames,
+                  c.frames / (seconds + 1), (unsigned long long)c.bytes, c.bytes / (seconds + 1),
+                  (unsigned long long)c.fullBytes, (unsigned)c.maxStaleMs, c.phase, ok ? "ok" : "MISMATCH");
+    }
+    return failures ? 1 : 0;
+  }
+
+  // Outbox clients: a WebSocket library send queue (frame count limited, like the real one) that
+  // drains at the client's link rate; a link rate of 0 from stallAtMs on models a dead phone link
+  constexpr size_t FAKE_QUEUE_FRAMES = 8;
+  struct FakeWsClient
+  {
+    const char *label;
+    uint32_t linkBytesPerSec;
+    uint32_t stallAtMs;
+    bool expectDrops;
+    bool expectDisconnect;
+    std::deque<size_t> queue;
+    size_t queuedBytes;
+    size_t maxQueuedBytes;
+    double linkCredit;
+    bool connected;
+    uint32_t closedAtMs;
+    uint32_t frames;
+    uint64_t bytes;
+    uint32_t lines;
+    uint32_t reportedDrops;
+    char phase[16];
+  };
+  FakeWsClient wsClients[3];
+  uint32_t outboxLines = 0;
+
+  bool FakeCanSend(uint32_t id)
+  {
+    const FakeWsClient &c = wsClients[id - 1];
+    return c.connected && c.queue.size() < FAKE_QUEUE_FRAMES;
+  }
+
+  void FakeSend(uint32_t id, const char *data, size_t len, bool)
+  {
+    FakeWsClient &c = wsClients[id - 1];
+    c.queue.push_back(len);
+    c.queuedBytes += len;
+    if (c.queuedBytes > c.maxQueuedBytes)
+      c.maxQueuedBytes = c.queuedBytes;
+    ++c.frames;
+    c.bytes += len;
+    if (std::strncmp(data, "{\"type\":\"log\",", 14) == 0)
+    {
+      ++c.lines;
+    }
+    else if (std::strncmp(data, "{\"type\":\"log_batch\",", 20) == 0)
+    {
+      if (const char *p = std::strstr(data, "\"dropped\":"))
+        c.reportedDrops += (uint32_t)std::strtoul(p + 10, nullptr, 10);
+      // Entries are [timestamp,"message"]; the load lines below never contain a '[' themselves
+      for (const char *p = std::strstr(data, "\"entries\":[") + 11; (p = std::strchr(p, '[')) != nullptr; ++p)
+        ++c.lines;
+    }
+    else if (const char *p = std::strstr(data, "\"phase\":\""))
+    {
+      p += 9;
+      const char *end = std::strchr(p, '"');
+      std::snprintf(c.phase, sizeof(c.phase), "%.*s", (int)(end - p), p);
+    }
+  }
+
+  void FakeClose(uint32_t id)
+  {
+    FakeWsClient &c = wsClients[id - 1];
+    c.connected = false;
+    c.closedAtMs = hal::Millis();
+    // What the disconnect event does on the device
+    OutboxRemoveClient(id);
+    StatusRemoveClient(id);
+  }
+
+  void FakeLinks(uint32_t nowMs, uint32_t stepMs)
+  {
+    for (FakeWsClient &c : wsClients)
+    {
+      if (!c.connected || nowMs >= c.stallAtMs)
+        continue;
+      c.linkCredit += c.linkBytesPerSec * stepMs / 1000.0;
+      while (!c.queue.empty() && c.linkCredit >= c.queue.front())
+      {
+        c.linkCredit -= c.queue.front();
+        c.queuedBytes -= c.queue.front();
+        c.queue.pop_front();
+      }
+      if (c.queue.empty() && c.linkCredit > 1500)
+        c.linkCredit = 1500; // an idle link does not bank bandwidth beyond a packet
+    }
+  }
+
+  void OnOutboxLog(const char *line, bool newline, uint32_t timestampMs)
+  {
+    if (!newline)
+      return;
+    OutboxLogLine(line, std::strlen(line), timestampMs);
+    ++outboxLines;
+  }
+
+  int RunOutbox(double seconds)
+  {
+    // Below this the slow client never falls far enough behind to lose history
+    constexpr double MIN_LOAD_SECONDS = 5.0;
+    if (seconds < MIN_LOAD_SECONDS)
+    {
+      std::printf("outbox needs at least %.0f s of load for the slow client to fall behind\n", MIN_LOAD_SECONDS);
+      return 1;
+    }
+    Boot();
+    hal::sim::SetLogEnabled(false);
+    hal::sim::SetLogSink(OnOutboxLog);
+    const uint32_t startMs = hal::Millis();
+    const uint32_t stallAtMs = startMs + (uint32_t)(seconds * 1000) / 4;
+    wsClients[0] = FakeWsClient{"fast", 1000000, UINT32_MAX, false, false, {}, 0, 0, 0, true, 0, 0, 0, 0, 0, ""};
+    wsClients[1] = FakeWsClient{"slow (1 KB/s)", 1000, UINT32_MAX, true, false, {}, 0, 0, 0, true, 0, 0, 0, 0, 0, ""};
+    wsClients[2] = FakeWsClient{"stalls", 1000000, stallAtMs, true, true, {}, 0, 0, 0, true, 0, 0, 0, 0, 0, ""};
+    OutboxBegin(OutboxTransport{FakeCanSend, FakeSend, FakeClose});
+    for (uint32_t id = 1; id <= 3; ++id)
+    {
+      OutboxAddClient(id, startMs);
+      StatusAddClient(id, startMs);
+    }
+
+    // Load: ~50 lines/s on top of the processor's own logs, then a quiet second to catch up
+    PressButton(1000);
+    const uint64_t endUs = hal::sim::NowUs() + (uint64_t)(seconds * 1e6);
+    // Short runs are stretched until the stalling client has had time to be disconnected
+    const uint64_t saturatedUs = (uint64_t)(stallAtMs + WS_CLIENT_SATURATED_MS + 1000) * 1000;
+    const uint64_t runEndUs = endUs + 2000000 > saturatedUs ? endUs + 2000000 : saturatedUs;
+    uint32_t n = 0;
+    uint64_t pumpNs = 0;
+    uint32_t pumps = 0;
+    bool stopped = false;
+    while (hal::sim::NowUs() < runEndUs)
+    {
+      hal::sim::AdvanceUs(1000);
+      ServiceProcessor();
+      const uint32_t nowMs = hal::Millis();
+      if (hal::sim::NowUs() < endUs && nowMs % 20 == 0)
+        LOGFLN("load %u: the quick brown fox jumps over the lazy dog", (unsigned)n++);
+      if (!stopped && hal::sim::NowUs() >= endUs)
+      {
+        ProcessorPostCommand(ProcessorCommand::BRAKE_STOP, 0.0f, CommandSource::CONSOLE);
+        stopped = true;
+      }
+      LogDrain();
+      const auto t0 = std::chrono::steady_clock::now();
+      StatusPublish(nowMs, WriteSimSystem, OutboxSend);
+      OutboxPump(nowMs);
+      pumpNs += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - t0).count();
+      ++pumps;
+      FakeLinks(nowMs, 1);
+    }
+    hal::sim::SetLogSink(nullptr);
+    hal::sim::SetLogEnabled(true);
+
+    ProcessorStatus st;
+    uint32_t version;
+    ProcessorGetStatus(st, version);
+    const char *phase = ProcessorPhaseName(st.phase);
+    OutboxClientStats stats[STATUS_MAX_CLIENTS];
+    const size_t live = OutboxGetClientStats(stats, STATUS_MAX_CLIENTS, hal::Millis());
+
+    int failures = 0;
+    std::printf("%u log lines, budget %u B/s (burst %u B), status + pump %.0f ns per pass\n", (unsigned)outboxLines,
+                (unsigned)WS_CLIENT_BYTES_PER_SEC, (unsigned)WS_CLIENT_BURST_BYTES, (double)pumpNs / pumps);
+    std::printf("client          frames    bytes  lines  dropped  max queued  last phase  result\n");
+    for (uint32_t id = 1; id <= 3; ++id)
+    {
+      const FakeWsClient &c = wsClients[id - 1];
+      uint32_t dropped = 0;
+      uint32_t backlog = 0;
+      for (size_t i = 0; i < live; ++i)
+        if (stats[i].id == id)
+        {
+          dropped = stats[i].logLinesDropped;
+          backlog = stats[i].logBacklog;
+        }
+      const char *problem = nullptr;
+      if (c.expectDisconnect)
+      {
+        const uint32_t after = c.closedAtMs - c.stallAtMs;
+        if (c.connected)
+          problem = "NOT DISCONNECTED";
+        else if (after < WS_CLIENT_SATURATED_MS || after > WS_CLIENT_SATURATED_MS + 1000)
+          problem = "DISCONNECT TIMING";
+      }
+      else if (!c.connected)
+        problem = "DISCONNECTED";
+      else if (c.lines + dropped + backlog != outboxLines || c.reportedDrops > dropped)
+        problem = "LINES LOST";
+      else if ((dropped > 0) != c.expectDrops)
+        problem = c.expectDrops ? "NO DROPS" : "DROPS";
+      else if (std::strcmp(c.phase, phase) != 0)
+        problem = "STALE STATE";
+      failures += problem != nullptr;
+      std::printf("%-14s %7u %8llu %6u %8u %11u  %10s  %s", c.label, (unsigned)c.frames, (unsigned long long)c.bytes,
+                  (unsigned)c.lines, (unsigned)(c.connected ? dropped : c.reportedDrops), (unsigned)c.maxQueuedBytes,
+                  c.phase, problem ? problem : "ok");
+      if (!c.connected)
+        std::printf(" (disconnected %u ms after stalling)", (unsigned)(c.closedAtMs - c.stallAtMs));
+      std::printf("\n");
+    }
+    return failures ? 1 : 0;
+  }
+
+  // ---------- Binary telemetry ----------
+  struct TelemetryClient
+  {
+    const char *label;
+    uint32_t hz;
+    uint32_t frames;
+    uint64_t bytes;
+    uint32_t records;
+    uint32_t dropped;
+    bool haveLast;
+    uint32_t lastUs;
+    uint32_t minGapUs;
+    uint32_t maxGapUs;
+    uint32_t maxDutyError; // worst |telemetry - PWM output|, duty counts
+    uint32_t unmatched;    // records with no reference sample
+    uint64_t jsonBytes;    // the same records as {"t":..,"in1":..,"in2":..,"phase":..} objects
+  };
+  TelemetryClient telemetryClients[2];
+
+  struct DutyPair
+  {
+    uint32_t in1;
+    uint32_t in2;
+  };
+  std::map<uint32_t, DutyPair> pwmReference; // PWM outputs by hal::Micros() at each tick
+
+  uint32_t Get16(const uint8_t *p) { return (uint32_t)p[0] | (uint32_t)p[1] << 8; }
+  uint32_t Get32(const uint8_t *p) { return Get16(p) | Get16(p + 2) << 16; }
+
+  bool OnTelemetryFrame(uint32_t clientId, const uint8_t *data, size_t len)
+  {
+    TelemetryClient &c = telemetryClients[clientId - 1];
+    ++c.frames;
+    c.bytes += len;
+    if (len < TELEMETRY_HEADER_BYTES || data[0] != TELEMETRY_FRAME_KIND || data[1] != TELEMETRY_RECORD_BYTES)
+      return true;
+    const uint32_t count = Get16(data + 2);
+    c.dropped += Get16(data + 6);
+    for (uint32_t i = 0; i < count && TELEMETRY_HEADER_BYTES + (i + 1) * TELEMETRY_RECORD_BYTES <= len; ++i)
+    {
+      const uint8_t *r = data + TELEMETRY_HEADER_BYTES + i * TELEMETRY_RECORD_BYTES;
+      const uint32_t us = Get32(r);
+      const uint32_t in1 = Get16(r + 4);
+      const uint32_t in2 = Get16(r + 6);
+      if (c.haveLast)
+      {
+        const uint32_t gap = us - c.lastUs;
+        c.minGapUs = gap < c.minGapUs ? gap : c.minGapUs;
+        c.maxGapUs = gap > c.maxGapUs ? gap : c.maxGapUs;
+      }
+      c.haveLast = true;
+      c.lastUs = us;
+      ++c.records;
+      char json[96];
+      c.jsonBytes += (uint64_t)std::snprintf(json, sizeof(json), "{\"t\":%u,\"in1\":%u,\"in2\":%u,\"phase\":\"%s\"}",
+                                             (unsigned)us, (unsigned)in1, (unsigned)in2,
+                                             ProcessorPhaseName((ProcessorPhase)r[8])) + 1; // + separator
+      const auto ref = pwmReference.find(us);
+      if (ref == pwmReference.end())
+      {
+        ++c.unmatched;
+        continue;
+      }
+      const uint32_t e1 = in1 > ref->second.in1 ? in1 - ref->second.in1 : ref->second.in1 - in1;
+      const uint32_t e2 = in2 > ref->second.in2 ? in2 - ref->second.in2 : ref->second.in2 - in2;
+      const uint32_t e = e1 > e2 ? e1 : e2;
+      c.maxDutyError = e > c.maxDutyError ? e : c.maxDutyError;
+    }
+    return true;
+  }
+
+  int RunTelemetry(double seconds)
+  {
+    Boot();
+    hal::sim::SetLogEnabled(false);
+    telemetryClients[0] = TelemetryClient{"200 Hz", 200, 0, 0, 0, 0, false, 0, UINT32_MAX, 0, 0, 0, 0};
+    telemetryClients[1] = TelemetryClient{"50 Hz", 50, 0, 0, 0, 0, false, 0, UINT32_MAX, 0, 0, 0, 0};
+    PressButton(1000);
+    TelemetrySubscribe(1, 200, hal::Millis());
+    TelemetrySubscribe(2, 50, hal::Millis());
+    const uint64_t endUs = hal::sim::NowUs() + (uint64_t)(seconds * 1e6);
+    while (hal::sim::NowUs() < endUs)
+    {
+      hal::sim::AdvanceUs(1000);
+      ServiceProcessor();
+      LogDrain();
+      pwmReference[hal::Micros()] = DutyPair{hal::sim::PwmDuty(cfg.pins.in1), hal::sim::PwmDuty(cfg.pins.in2)};
+      TelemetryPump(hal::Millis(), OnTelemetryFrame);
+      while (pwmReference.size() > 1000) // a second of ticks covers any batch
+        pwmReference.erase(pwmReference.begin());
+    }
+    hal::sim::SetLogEnabled(true);
+
+    // 1% of full scale
+    const uint32_t tolerance = ((1u << cfg.pwmBits) - 1u) / 100u;
+    const TelemetryStats stats = TelemetryGetStats();
+    std::printf("%u samples taken, %u overruns; frame %u B header + %u B per record\n", (unsigned)stats.samples,
+                (unsigned)stats.overruns, (unsigned)TELEMETRY_HEADER_BYTES, (unsigned)TELEMETRY_RECORD_BYTES);
+    std::printf("client   frames  records  dropped  gap min/max (us)  max duty err  bytes/s  (as JSON)  result\n");
+    int failures = 0;
+    for (const TelemetryClient &c : telemetryClients)
+    {
+      const uint32_t intervalUs = 1000000u / c.hz;
+      const char *problem = nullptr;
+      if (c.records < (uint32_t)(seconds * c.hz * 0.95))
+        problem = "TOO FEW RECORDS";
+      else if (c.dropped || stats.overruns)
+        problem = "DROPS";
+      else if (c.minGapUs + TELEMETRY_SAMPLE_US / 2 < intervalUs || c.maxGapUs > intervalUs + TELEMETRY_SAMPLE_US / 2)
+        problem = "SPACING";
+      else if (c.unmatched || c.maxDutyError > tolerance)
+        problem = "DUTY MISMATCH";
+      failures += problem != nullptr;
+      std::printf("%-7s %7u %8u %8u  %7u/%-8u  %12u %8.0f %10.0f  %s\n", c.label, (unsigned)c.frames,
+                  (unsigned)c.records, (unsigned)c.dropped, (unsigned)c.minGapUs, (unsigned)c.maxGapUs,
+                  (unsigned)c.maxDutyError, c.bytes / seconds, c.jsonBytes / seconds, problem ? problem : "ok");
+    }
+    return failures ? 1 : 0;
+  }
+
+  // ---------- Event trace ----------
+  bool TraceCanSend(uint32_t) { return true; }
+  void TraceSend(uint32_t, const char *, size_t, bool) {}
+  void TraceClose(uint32_t) {}
+
+  int RunTrace(double seconds, const char *path)
+  {
+    Boot();
+    hal::sim::SetLogEnabled(false);
+    OutboxBegin(OutboxTransport{TraceCanSend, TraceSend, TraceClose});
+    OutboxAddClient(1, hal::Millis());
+    StatusAddClient(1, hal::Millis());
+
+    PressButton(1000);
+    const uint64_t startUs = hal::sim::NowUs();
+    const uint64_t endUs = startUs + (uint64_t)(seconds * 1e6);
+    bool tuned = false;
+    bool stopped = false;
+    while (hal::sim::NowUs() < endUs + 1000000)
+    {
+      hal::sim::AdvanceUs(1000);
+      ServiceProcessor();
+      LogDrain();
+      if (!tuned && hal::sim::NowUs() - startUs > (endUs - startUs) / 2)
+      {
+        ProcessorPostCommand(ProcessorCommand::SET_CRUISE, 80.0f, CommandSource::NETWORK);
+        tuned = true;
+      }
+      if (!stopped && hal::sim::NowUs() >= endUs)
+      {
+        ProcessorPostCommand(ProcessorCommand::BRAKE_STOP, 0.0f, CommandSource::CONSOLE);
+        stopped = true;
+      }
+      StatusPublish(hal::Millis(), WriteSimSystem, OutboxSend);
+      OutboxPump(hal::Millis());
+    }
+    hal::sim::SetLogEnabled(true);
+
+    FILE *f = std::fopen(path, "w");
+    if (!f)
+    {
+      std::printf("cannot write %s\n", path);
+      return 1;
+    }
+    TraceChromeWriter writer;
+    char buf[512];
+    size_t n;
+    size_t bytes = 0;
+    while ((n = writer.Fill(buf, sizeof(buf))) > 0)
+    {
+      std::fwrite(buf, 1, n, f);
+      bytes += n;
+    }
+    std::fclose(f);
+    const TraceStats st = TraceGetStats();
+    std::printf("%u events recorded, newest %u exported: %zu bytes to %s (open in ui.perfetto.dev)\n",
+                (unsigned)st.recorded, (unsigned)(st.recorded < st.capacity ? st.recorded : st.capacity), bytes, path);
+    return 0;
+  }
+
+  // ---------- Motor / tank model ----------
+  constexpr float RAD_PER_S_TO_RPM = 60.0f / 6.2831853f;
+
+  // Runs the auto cycle with the given timings for seconds of virtual time, the model following the
+  // bridge duties every millisecond
+  MotorRunStats RunPlant(const ProcessorTimings &timings, const MotorParams &params, float cruiseSpeed, double seconds)
+  {
+    Boot();
+    cfg.t = timings;
+    InitializeProcessor(cfg);
+    // InitializeProcessor() leaves the phase machine alone: stop whatever the previous run left
+    // going, so each run starts from rest like the model does
+    ProcessorCommandBrakeStop();
+    ProcessorCommandAllOff();
+    MotorModel motor(params);
+    MotorRunRecorder recorder(params, cruiseSpeed);
+    const float full = (float)((1u << cfg.pwmBits) - 1u);
+    ProcessorPostCommand(ProcessorCommand::AUTO_START, 0.0f, CommandSource::CONSOLE);
+    const uint64_t endUs = hal::sim::NowUs() + (uint64_t)(seconds * 1e6);
+    while (hal::sim::NowUs() < endUs)
+    {
+      hal::sim::AdvanceUs(1000);
+      ServiceProcessor();
+      LogDrain();
+      motor.Advance(hal::sim::PwmDuty(cfg.pins.in1) / full, hal::sim::PwmDuty(cfg.pins.in2) / full, 0.001f);
+      recorder.Sample(motor, 0.001f);
+    }
+    return recorder.Finish();
+  }
+
+  void PrintPlantHeader()
+  {
+    std::printf("ramp up  ramp down  coast  reversals  dead mean/max (ms)  at speed  peak A  ILIM ms  impact rpm  slip rpm  verdict\n");
+  }
+
+  void PrintPlantRow(const ProcessorTimings &t, const MotorRunStats &s, const char *note)
+  {
+    std::printf("%7u %10u %6u %10u %9.0f/%-8.0f %8.1f%% %7.2f %8.0f %11.1f %9.1f  %s%s\n", (unsigned)t.rampUpMs,
+                (unsigned)t.rampDownMs, (unsigned)t.coastBetweenMs, (unsigned)s.reversals, s.meanDeadMs, s.maxDeadMs,
+                100.0f * s.timeAtSpeed, s.peakCurrentA, s.limitMs, s.maxImpactRadPerS * RAD_PER_S_TO_RPM,
+                s.meanFluidSlip * RAD_PER_S_TO_RPM, s.safe ? "safe" : "UNSAFE", note);
+  }
+
+  void PrintPlantParams(const MotorParams &params, float cruiseSpeed)
+  {
+    std::printf("%.1f V supply, cruise %.1f%% -> %.1f rpm at the tank; safe: peak <= %.1f A, backlash closing <= %.1f rpm\n",
+                params.supplyV, cfg.cruisePct, cruiseSpeed * RAD_PER_S_TO_RPM, params.safeCurrentA,
+                params.safeImpactRadPerS * RAD_PER_S_TO_RPM);
+  }
+
+  int RunMotor(double seconds, float volts)
+  {
+    hal::sim::SetLogEnabled(false);
+    cfg = getPlatformConfig();
+    MotorParams params;
+    params.supplyV = volts;
+    params.pwmHz = (float)cfg.pwmHz;
+    const float cruiseSpeed = MotorModel::SteadySpeed(params, cfg.cruisePct / 100.0f);
+    const ProcessorTimings timings = cfg.t;
+    const MotorRunStats s = RunPlant(timings, params, cruiseSpeed, seconds);
+    hal::sim::SetLogEnabled(true);
+    PrintPlantParams(params, cruiseSpeed);
+    PrintPlantHeader();
+    PrintPlantRow(timings, s, "");
+    return 0;
+  }
+
+  int RunSweep(double seconds, float volts)
+  {
+    hal::sim::SetLogEnabled(false);
+    cfg = getPlatformConfig();
+    const ProcessorTimings current = cfg.t;
+    // Dead time is only measured across a reversal: a run must at least get into the second one
+    const double minSeconds = ((double)current.forwardRunMs + current.reverseRunMs) / 1000.0;
+    if (seconds < minSeconds)
+    {
+      hal::sim::SetLogEnabled(true);
+      std::printf("sweep needs at least %.1f s (one forward and one reverse run) to see a reversal\n", minSeconds);
+      return 1;
+    }
+    MotorParams params;
+    params.supplyV = volts;
+    params.pwmHz = (float)cfg.pwmHz;
+    const float cruiseSpeed = MotorModel::SteadySpeed(params, cfg.cruisePct / 100.0f);
+
+    static const uint16_t RAMP_MS[] = {15, 100, 250, 500, 1000};
+    static const uint16_t COAST_MS[] = {60, 200, 500, 1000};
+    struct Result
+    {
+      ProcessorTimings t;
+      MotorRunStats s;
+    };
+    std::vector<Result> results;
+    for (uint16_t up : RAMP_MS)
+      for (uint16_t down : RAMP_MS)
+        for (uint16_t coast : COAST_MS)
+        {
+          ProcessorTimings t = current;
+          t.rampUpMs = up;
+          t.rampDownMs = down;
+          t.coastBetweenMs = coast;
+          results.push_back(Result{t, RunPlant(t, params, cruiseSpeed, seconds)});
+        }
+    const MotorRunStats now = RunPlant(current, params, cruiseSpeed, seconds);
+    hal::sim::SetLogEnabled(true);
+
+    // Fastest safe first: shortest reversal dead time, then most time at speed. A set that never
+    // completed a reversal has no dead time to rank by and goes last.
+    std::stable_sort(results.begin(), results.end(), [](const Result &a, const Result &b)
+    {
+      if ((a.s.reversals == 0) != (b.s.reversals == 0))
+        return b.s.reversals == 0;
+      if (a.s.safe != b.s.safe)
+        return a.s.safe;
+      if (a.s.meanDeadMs != b.s.meanDeadMs)
+        return a.s.meanDeadMs < b.s.meanDeadMs;
+      return a.s.timeAtSpeed > b.s.timeAtSpeed;
+    });
+    size_t safe = 0;
+    for (const Result &r : results)
+      safe += r.s.safe;
+
+    PrintPlantParams(params, cruiseSpeed);
+    std::printf("%zu timing sets, %.0f s each: %zu safe\n", results.size(), seconds, safe);
+    PrintPlantHeader();
+    for (size_t i = 0; i < results.size() && i < 10 && results[i].s.safe && results[i].s.reversals; ++i)
+      PrintPlantRow(results[i].t, results[i].s, i == 0 ? "  <- fastest safe" : "");
+    PrintPlantRow(current, now, "  <- current settings");
+    return 0;
+  }
+
+  void Usage()
+  {
+    std::printf("usage: program sim [hours] [tickUs] | bench [calls] | rampcheck | metrics [seconds] | status [seconds] | outbox [seconds] | telemetry [seconds] | trace [seconds] [file] | motor [seconds] [volts] | sweep [seconds] [volts] | stress [seconds]\n");
+  }
+} // namespace
+
+int main(int argc, char **argv)
+{
+  if (argc < 2)
+  {
+    Usage();
+    return 1;
+  }
+
+  if (std::strcmp(argv[1], "sim") == 0)
+  {
+    const double hours = argc > 2 ? std::atof(argv[2]) : 1.0;
+    const uint32_t tickUs = argc > 3 ? (uint32_t)std::strtoul(argv[3], nullptr, 10) : 1000;
+    return RunSim(hours, tickUs ? tickUs : 1000);
+  }
+  if (std::strcmp(argv[1], "bench") == 0)
+  {
+    const uint64_t calls = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 10000000ull;
+    return RunBench(calls ? calls : 1);
+  }
+
+  if (std::strcmp(argv[1], "rampcheck") == 0)
+    return RunRampCheck();
+  if (std::strcmp(argv[1], "metrics") == 0)
+  {
+    const double seconds = argc > 2 ? std::atof(argv[2]) : 60.0;
+    return RunMetrics(seconds > 0 ? seconds : 60.0);
+  }
+  if (std::strcmp(argv[1], "status") == 0)
+  {
+    const double seconds = argc > 2 ? std::atof(argv[2]) : 60.0;
+    return RunStatus(seconds > 0 ? seconds : 60.0);
+  }
+  if (std::strcmp(argv[1], "outbox") == 0)
+  {
+    const double seconds = argc > 2 ? std::atof(argv[2]) : 30.0;
+    return RunOutbox(seconds > 0 ? seconds : 30.0);
+  }
+  if (std::strcmp(argv[1], "telemetry") == 0)
+  {
+    const double seconds = argc > 2 ? std::atof(argv[2]) : 20.0;
+    return RunTelemetry(seconds > 0 ? seconds : 20.0);
+  }
+  if (std::strcmp(argv[1], "trace") == 0)
+  {
+    const double seconds = argc > 2 ? std::atof(argv[2]) : 20.0;
+    return RunTrace(seconds > 0 ? seconds : 20.0, argc > 3 ? argv[3] : "trace.json");
+  }
+  if (std::strcmp(argv[1], "motor") == 0 || std::strcmp(argv[1], "sweep") == 0)
+  {
+    const double seconds = argc > 2 ? std::atof(argv[2]) : 45.0;
+    const float volts = argc > 3 ? (float)std::atof(argv[3]) : 12.0f;
+    if (argv[1][0] == 'm')
+      return RunMotor(seconds > 0 ? seconds : 45.0, volts > 0 ? volts : 12.0f);
+    return RunSweep(seconds > 0 ? seconds : 45.0, volts > 0 ? volts : 12.0f);
+  }
+  if (std::strcmp(argv[1], "stress") == 0)
+  {
+    const double seconds = argc > 2 ? std::atof(argv[2]) : 5.0;
+    return RunStress(seconds > 0 ? seconds : 5.0);
+  }
+
+  Usage();
+  return 1;
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+// Bounded single-producer/single-consumer ring. Lock-free: the producer only writes head, the
+// consumer only writes tail, and each publishes with release/acquire ordering. N must be a power
+// of two. Claim()/Publish() and Peek()/Pop() let either side work on a slot in place.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+
+template <typename T, size_t N>
+class SpscRing
+{
+  static_assert(N > 0 && (N & (N - 1)) == 0, "SpscRing size must be a power of two");
+
+public:
+  // ---------- Producer side ----------
+  T *Claim()
+  {
+    const uint32_t head = head_.load(std::memory_order_relaxed);
+    if (head - tail_.load(std::memory_order_acquire) >= N)
+      return nullptr; // full
+    return &buf_[head & (N - 1)];
+  }
+
+  void Publish()
+  {
+    head_.store(head_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+  }
+
+  bool Push(const T &value)
+  {
+    T *slot = Claim();
+    if (!slot)
+      return false;
+    *slot = value;
+    Publish();
+    return true;
+  }
+
+  // ---------- Consumer side ----------
+  T *Peek()
+  {
+    const uint32_t tail = tail_.load(std::memory_order_relaxed);
+    if (head_.load(std::memory_order_acquire) == tail)
+      return nullptr; // empty
+    return &buf_[tail & (N - 1)];
+  }
+
+  void Pop()
+  {
+    tail_.store(tail_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+  }
+
+  bool Pop(T &out)
+  {
+    T *slot = Peek();
+    if (!slot)
+      return false;
+    out = *slot;
+    Pop();
+    return true;
+  }
+
+  // ---------- Either side (approximate while the other side is running) ----------
+  size_t Size() const
+  {
+    return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+  }
+  static constexpr size_t Capacity() { return N; }
+
+private:
+  T buf_[N];
+  std::atomic<uint32_t> head_{0};
+  std::atomic<uint32_t> tail_{0};
+};
@@ -0,0 +1,213 @@
+#include "status_channel.h"
+#include "metrics.h"
+#include "status_json.h"
+#include <string.h>
+
+namespace
+{
+  constexpr uint8_t Bit(StatusTopic t) { return (uint8_t)(1u << (uint8_t)t); }
+  constexpr uint8_t CHANGE_TOPICS = Bit(StatusTopic::MOTION) | Bit(StatusTopic::CONFIG);
+
+  const char *const TOPIC_NAMES[STATUS_TOPICS] = {"motion", "config", "system", "metrics"};
+
+  struct Client
+  {
+    uint32_t id;
+    bool used;
+    uint8_t topics;  // subscribed
+    uint8_t synced;  // change topics whose full state this client has received
+    uint32_t intervalMs[STATUS_TOPICS];
+    uint32_t lastSentMs[STATUS_TOPICS];
+    ProcessorStatus seen; // state as of the last frame sent to this client
+  };
+  Client clients[STATUS_MAX_CLIENTS];
+
+  char stateFrame[384]; // per client (deltas differ)
+  // Periodic frames are the same for every client, so each is built at most once per pass
+  char systemFrame[160];
+  char metricsFrame[448];
+
+  Client *Find(uint32_t id)
+  {
+    for (Client &c : clients)
+      if (c.used && c.id == id)
+        return &c;
+    return nullptr;
+  }
+
+  inline bool Due(const Client &c, StatusTopic t, uint32_t nowMs)
+  {
+    const uint8_t i = (uint8_t)t;
+    return (c.topics & Bit(t)) && nowMs - c.lastSentMs[i] >= c.intervalMs[i];
+  }
+
+  bool MotionChanged(const ProcessorStatus &a, const ProcessorStatus &b)
+  {
+    return a.phase != b.phase || a.running != b.running || a.forward != b.forward || a.duty != b.duty;
+  }
+
+  bool ConfigChanged(const ProcessorStatus &a, const ProcessorStatus &b)
+  {
+    return a.cruisePctQ16 != b.cruisePctQ16 || a.dutyMax != b.dutyMax ||
+           a.t.forwardRunMs != b.t.forwardRunMs || a.t.reverseRunMs != b.t.reverseRunMs ||
+           a.t.rampUpMs != b.t.rampUpMs || a.t.rampDownMs != b.t.rampDownMs ||
+           a.t.coastBetweenMs != b.t.coastBetweenMs || a.t.rampProfile != b.t.rampProfile;
+  }
+
+  // Change topics with something new for this client that its rate limit lets through
+  uint8_t DueChanges(const Client &c, const ProcessorStatus &cur, uint32_t nowMs)
+  {
+    uint8_t due = 0;
+    if (Due(c, StatusTopic::MOTION, nowMs) &&
+        (!(c.synced & Bit(StatusTopic::MOTION)) || MotionChanged(cur, c.seen)))
+      due |= Bit(StatusTopic::MOTION);
+    if (Due(c, StatusTopic::CONFIG, nowMs) &&
+        (!(c.synced & Bit(StatusTopic::CONFIG)) || ConfigChanged(cur, c.seen)))
+      due |= Bit(StatusTopic::CONFIG);
+    return due;
+  }
+
+  void MarkSeen(Client &c, const ProcessorStatus &cur, uint8_t topics)
+  {
+    if (topics & Bit(StatusTopic::MOTION))
+    {
+      c.seen.phase = cur.phase;
+      c.seen.running = cur.running;
+      c.seen.forward = cur.forward;
+      c.seen.duty = cur.duty;
+    }
+    if (topics & Bit(StatusTopic::CONFIG))
+    {
+      c.seen.cruisePctQ16 = cur.cruisePctQ16;
+      c.seen.dutyMax = cur.dutyMax;
+      c.seen.t = cur.t;
+    }
+    c.synced |= topics;
+  }
+} // namespace
+
+bool StatusTopicMask(const char *name, size_t len, uint8_t &mask)
+{
+  if (len == 3 && strncmp(name, "all", 3) == 0)
+  {
+    mask = STATUS_ALL_TOPICS;
+    return true;
+  }
+  for (size_t i = 0; i < STATUS_TOPICS; ++i)
+  {
+    if (strncmp(TOPIC_NAMES[i], name, len) == 0 && TOPIC_NAMES[i][len] == '\0')
+    {
+      mask = (uint8_t)(1u << i);
+      return true;
+    }
+  }
+  return false;
+}
+
+bool StatusAddClient(uint32_t clientId, uint32_t nowMs)
+{
+  Client *c = Find(clientId);
+  for (size_t i = 0; !c && i < STATUS_MAX_CLIENTS; ++i)
+    if (!clients[i].used)
+      c = &clients[i];
+  if (!c)
+    return false;
+  *c = Client{};
+  c->id = clientId;
+  c->used = true;
+  c->topics = STATUS_ALL_TOPICS;
+  for (size_t i = 0; i < STATUS_TOPICS; ++i)
+  {
+    c->intervalMs[i] = (CHANGE_TOPICS & (1u << i)) ? STATUS_CHANGE_INTERVAL_MS : STATUS_PERIODIC_INTERVAL_MS;
+    c->lastSentMs[i] = nowMs - c->intervalMs[i]; // first frame goes out on the next pass
+  }
+  return true;
+}
+
+void StatusRemoveClient(uint32_t clientId)
+{
+  if (Client *c = Find(clientId))
+    c->used = false;
+}
+
+bool StatusSubscribe(uint32_t clientId, uint8_t topics, bool on, uint32_t intervalMs)
+{
+  Client *c = Find(clientId);
+  if (!c)
+    return false;
+  topics &= STATUS_ALL_TOPICS;
+  if (!on)
+  {
+    c->topics &= (uint8_t)~topics;
+    return true;
+  }
+  if (intervalMs < STATUS_MIN_INTERVAL_MS)
+    intervalMs = STATUS_MIN_INTERVAL_MS;
+  for (size_t i = 0; i < STATUS_TOPICS; ++i)
+  {
+    if (!(topics & (1u << i)))
+      continue;
+    c->intervalMs[i] = intervalMs;
+    c->lastSentMs[i] -= intervalMs; // a newly subscribed or faster topic is due right away
+  }
+  c->topics |= topics;
+  c->synced &= (uint8_t)~topics;
+  return true;
+}
+
+void StatusPublish(uint32_t nowMs, StatusSystemWriter writeSystem, StatusSendFn send)
+{
+  ProcessorStatus cur;
+  uint32_t version;
+  const bool haveState = ProcessorGetStatus(cur, version);
+  size_t systemLen = 0;  // 0: not built yet this pass
+  size_t metricsLen = 0;
+
+  for (Client &c : clients)
+  {
+    if (!c.used)
+      continue;
+
+    // State delta: only fields this client has not seen, for the topics due now
+    const uint8_t due = haveState ? DueChanges(c, cur, nowMs) : 0;
+    if (due)
+    {
+      JsonWriter w(stateFrame, sizeof(stateFrame));
+      w.BeginObject().Field("type", "state");
+      if (due & Bit(StatusTopic::MOTION))
+        WriteMotionJson(w, cur, (c.synced & Bit(StatusTopic::MOTION)) ? &c.seen : nullptr);
+      if (due & Bit(StatusTopic::CONFIG))
+        WriteConfigJson(w, cur, (c.synced & Bit(StatusTopic::CONFIG)) ? &c.seen : nullptr);
+      w.EndObject();
+      if (w.Ok() && send(c.id, w.Data(), w.Length()))
+      {
+        MarkSeen(c, cur, due);
+        for (size_t i = 0; i < STATUS_TOPICS; ++i)
+          if (due & (1u << i))
+            c.lastSentMs[i] = nowMs;
+      }
+    }
+
+    if (Due(c, StatusTopic::SYSTEM, nowMs))
+    {
+      if (systemLen == 0)
+      {
+        JsonWriter w(systemFrame, sizeof(systemFrame));
+        w.BeginObject().Field("type", "status");
+        writeSystem(w);
+        w.EndObject();
+        systemLen = w.Ok() ? w.Length() : 0;
+      }
+      if (systemLen > 0 && send(c.id, systemFrame, systemLen))
+        c.lastSentMs[(uint8_t)StatusTopic::SYSTEM] = nowMs;
+    }
+
+    if (Due(c, StatusTopic::METRICS, nowMs))
+    {
+      if (metricsLen == 0)
+        metricsLen = MetricsFormatCompact(metricsFrame, sizeof(metricsFrame));
+      if (metricsLen > 0 && send(c.id, metricsFrame, metricsLen))
+        c.lastSentMs[(uint8_t)StatusTopic::METRICS] = nowMs;
+    }
+  }
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+// Change-driven status push with per-client topic subscriptions and rate limits.
+// MOTION and CONFIG go out as deltas ({"type":"state",...} with only the fields that changed since
+// that client's previous frame) as soon as the processor publishes a change; a client's max rate
+// only holds back changes that follow its previous frame too closely, and those are coalesced
+// into the next one. SYSTEM ({"type":"status",...}) and METRICS (metrics.h) are periodic.
+// Transport-agnostic: the owner supplies the send function, so the native build can drive it.
+
+#include "json_writer.h"
+
+enum class StatusTopic : uint8_t {
+  MOTION,  // phase, running, direction, duty: pushed on change
+  CONFIG,  // cruise, duty range, timings, ramp profile: pushed on change
+  SYSTEM,  // uptime, heap, RSSI: sent every interval
+  METRICS  // compact metrics frame: sent every interval
+};
+constexpr size_t STATUS_TOPICS = 4;
+constexpr uint8_t STATUS_ALL_TOPICS = (1u << STATUS_TOPICS) - 1;
+
+#ifndef STATUS_MAX_CLIENTS
+  #if defined(ESP8266)
+    #define STATUS_MAX_CLIENTS 4
+  #else
+    #define STATUS_MAX_CLIENTS 8
+  #endif
+#endif
+
+#ifndef STATUS_CHANGE_INTERVAL_MS
+  #define STATUS_CHANGE_INTERVAL_MS 50 // default min spacing of MOTION/CONFIG frames (20 Hz)
+#endif
+
+#ifndef STATUS_PERIODIC_INTERVAL_MS
+  #define STATUS_PERIODIC_INTERVAL_MS 2000 // default SYSTEM/METRICS period
+#endif
+
+#ifndef STATUS_MIN_INTERVAL_MS
+  #define STATUS_MIN_INTERVAL_MS 20 // fastest rate a client may ask for
+#endif
+
+// "motion", "config", "system", "metrics" or "all" -> topic bit mask; false if unknown
+bool StatusTopicMask(const char *name, size_t len, uint8_t &mask);
+
+// Writes the SYSTEM members into the open status object; sends one frame to one client and
+// returns false if it was not sent (the channel retries with fresher data on a later pass)
+typedef void (*StatusSystemWriter)(JsonWriter &w);
+typedef bool (*StatusSendFn)(uint32_t clientId, const char *json, size_t len);
+
+// Everything below is called from one thread (loop()).
+
+// New clients are subscribed to every topic at the default rates. False if no slot is free.
+bool StatusAddClient(uint32_t clientId, uint32_t nowMs);
+void StatusRemoveClient(uint32_t clientId);
+
+// (Un)subscribe topics for a client; intervalMs is the min spacing of its frames per topic
+// (clamped to STATUS_MIN_INTERVAL_MS). Subscribing again re-sends the full state. False if the
+// client is unknown.
+bool StatusSubscribe(uint32_t clientId, uint8_t topics, bool on, uint32_t intervalMs);
+
+// Sends whatever is due to each client; call every loop() pass
+void StatusPublish(uint32_t nowMs, StatusSystemWriter writeSystem, StatusSendFn send);
@@ -0,0 +1,101 @@
+#include "status_json.h"
+#include "boot_profile.h"
+#include "platform_config.h"
+#include "processor.h"
+#include "processor_task.h"
+
+void WriteLogJson(JsonWriter &w, uint32_t timestampMs, const char *message, size_t len)
+{
+  w.BeginObject().Field("type", "log");
+  w.Key("timestamp").Uint(timestampMs);
+  w.Key("message").String(message, len);
+  w.EndObject();
+}
+
+void WriteProcessorStatusJson(JsonWriter &w)
+{
+  const ProcessorSchedulerStats sched = ProcessorGetSchedulerStats();
+  w.Key("sched").BeginObject();
+  w.Key("transitions").Uint(sched.transitions);
+  w.Key("resyncs").Uint(sched.resyncs);
+  w.Key("late_min_us").Uint(sched.minLateUs);
+  w.Key("late_max_us").Uint(sched.maxLateUs);
+  w.Key("late_mean_us").Uint(sched.meanLateUs);
+  w.Key("late_hist").BeginArray();
+  for (size_t i = 0; i < PROCESSOR_LATENESS_BUCKETS; ++i)
+    w.Uint(sched.histogram[i]);
+  w.EndArray().EndObject();
+
+  #if PROCESSOR_TASK
+    const ProcessorTaskStats task = ProcessorGetTaskStats();
+    w.Key("task").BeginObject();
+    w.Key("running").Bool(task.running);
+    w.Key("period_us").Uint(task.periodUs);
+    w.Key("ticks").Uint(task.ticks);
+    w.Key("overruns").Uint(task.overruns);
+    w.Key("late_max_us").Uint(task.maxLateUs);
+    w.EndObject();
+  #endif
+
+  const ProcessorCommandStats cmd = ProcessorGetCommandStats();
+  w.Key("cmd").BeginObject();
+  w.Key("posted").Uint(cmd.posted);
+  w.Key("executed").Uint(cmd.executed);
+  w.Key("rejected").Uint(cmd.rejected);
+  w.Key("latency_min_us").Uint(cmd.minLatencyUs);
+  w.Key("latency_max_us").Uint(cmd.maxLatencyUs);
+  w.Key("latency_mean_us").Uint(cmd.meanLatencyUs);
+  w.EndObject();
+}
+
+void WriteMotionJson(JsonWriter &w, const ProcessorStatus &s, const ProcessorStatus *prev)
+{
+  if (!prev || s.phase != prev->phase)
+    w.Field("phase", ProcessorPhaseName(s.phase));
+  if (!prev || s.running != prev->running)
+    w.Key("running").Bool(s.running);
+  if (!prev || s.forward != prev->forward)
+    w.Field("dir", s.forward ? "fwd" : "rev");
+  if (!prev || s.duty != prev->duty)
+    w.Key("duty").Uint(s.duty);
+}
+
+void WriteConfigJson(JsonWriter &w, const ProcessorStatus &s, const ProcessorStatus *prev)
+{
+  const ProcessorTimings &t = s.t;
+  if (!prev || s.cruisePctQ16 != prev->cruisePctQ16)
+    w.Key("cruise").Fixed(((uint64_t)s.cruisePctQ16 * 10u + 0x8000u) >> 16, 1);
+  if (!prev || s.dutyMax != prev->dutyMax)
+    w.Key("duty_max").Uint(s.dutyMax);
+  if (!prev || t.forwardRunMs != prev->t.forwardRunMs)
+    w.Key("fwd_ms").Uint(t.forwardRunMs);
+  if (!prev || t.reverseRunMs != prev->t.reverseRunMs)
+    w.Key("rev_ms").Uint(t.reverseRunMs);
+  if (!prev || t.rampUpMs != prev->t.rampUpMs)
+    w.Key("ramp_up_ms").Uint(t.rampUpMs);
+  if (!prev || t.rampDownMs != prev->t.rampDownMs)
+    w.Key("ramp_down_ms").Uint(t.rampDownMs);
+  if (!prev || t.coastBetweenMs != prev->t.coastBetweenMs)
+    w.Key("coast_ms").Uint(t.coastBetweenMs);
+  if (!prev || t.rampProfile != prev->t.rampProfile)
+    w.Field("profile", RampProfileName(t.rampProfile));
+}
+
+void WriteBootJson(JsonWriter &w)
+{
+  w.BeginObject().Field("platform", getPlatformName());
+  w.Field("build", __DATE__ " " __TIME__);
+  w.Key("ready_us").Uint(BootReadyUs());
+  w.Key("stages").BeginArray();
+  uint32_t prev = 0;
+  for (size_t i = 0, n = BootStageCount(); i < n; ++i)
+  {
+    const BootStage st = BootStageAt(i);
+    w.BeginObject().Field("name", st.name);
+    w.Key("us").Uint(st.us);
+    w.Key("delta_us").Uint(st.us - prev);
+    w.EndObject();
+    prev = st.us;
+  }
+  w.EndArray().EndObject();
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+// JSON payloads shared by the WebSocket and HTTP endpoints, written with JsonWriter (json_writer.h)
+// straight into the caller's buffer. Kept free of the network stack so the native build can
+// benchmark them.
+
+#include "json_writer.h"
+#include "processor.h"
+
+// {"type":"log","timestamp":ms,"message":"..."}
+void WriteLogJson(JsonWriter &w, uint32_t timestampMs, const char *message, size_t len);
+
+// "sched":{...},"task":{...},"cmd":{...} members, appended to the currently open object
+// ("task" only with PROCESSOR_TASK)
+void WriteProcessorStatusJson(JsonWriter &w);
+
+// ProcessorStatus members, appended to the currently open object. With prev, only the fields that
+// differ from it are written (a delta); without, all of them.
+//   motion: "phase","running","dir" ("fwd"/"rev"),"duty"
+//   config: "cruise" (%),"duty_max","fwd_ms","rev_ms","ramp_up_ms","ramp_down_ms","coast_ms","profile"
+void WriteMotionJson(JsonWriter &w, const ProcessorStatus &s, const ProcessorStatus *prev = nullptr);
+void WriteConfigJson(JsonWriter &w, const ProcessorStatus &s, const ProcessorStatus *prev = nullptr);
+
+// {"platform":"...","build":"...","ready_us":n,"stages":[{"name":"...","us":n,"delta_us":n},...]}
+void WriteBootJson(JsonWriter &w);
@@ -0,0 +1,215 @@
+#include "telemetry.h"
+#include "processor.h"
+#include "spsc_ring.h"
+#include <atomic>
+
+namespace
+{
+  // ---------- Processor side ----------
+  std::atomic<bool> enabled{false}; // any subscriber; written by loop()
+  uint32_t lastSampleUs = 0;
+  bool overrun = false;
+  std::atomic<uint32_t> samplesTaken{0}; // single writer, so plain load/store pairs
+  std::atomic<uint32_t> overruns{0};
+
+  SpscRing<TelemetrySample, 32> ring; // processor -> loop(); 160 ms of slack at 200 Hz
+
+  // ---------- loop() side ----------
+  TelemetrySample history[TELEMETRY_HISTORY];
+  uint32_t historySeq = 0; // sequence number of the next sample; sample s lives at s % HISTORY
+
+  struct Client
+  {
+    uint32_t id;
+    bool used;
+    bool kept;         // lastKeptUs is valid
+    uint32_t intervalUs;
+    uint32_t lastKeptUs;
+    uint32_t seq;      // next history sample to look at
+    uint32_t lastFrameMs;
+    uint32_t dropped;  // records missed since the last frame
+  };
+  Client clients[STATUS_MAX_CLIENTS];
+
+  uint8_t frame[TELEMETRY_FRAME_BYTES];
+
+  Client *Find(uint32_t id)
+  {
+    for (Client &c : clients)
+      if (c.used && c.id == id)
+        return &c;
+    return nullptr;
+  }
+
+  void UpdateEnabled()
+  {
+    bool any = false;
+    for (const Client &c : clients)
+      any = any || c.used;
+    enabled.store(any, std::memory_order_relaxed);
+  }
+
+  inline void Put16(uint8_t *p, uint16_t v)
+  {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+  }
+
+  inline void Put32(uint8_t *p, uint32_t v)
+  {
+    Put16(p, (uint16_t)v);
+    Put16(p + 2, (uint16_t)(v >> 16));
+  }
+
+  // Records the client would have got from n raw samples at its rate
+  inline uint32_t AtClientRate(const Client &c, uint32_t n)
+  {
+    return (uint32_t)((uint64_t)n * TELEMETRY_SAMPLE_US / c.intervalUs);
+  }
+
+  // Fills frame[] with the client's decimated samples since its last frame; returns the length
+  size_t BuildFrame(Client &c, uint16_t dutyMax)
+  {
+    if (historySeq - c.seq > TELEMETRY_HISTORY)
+    {
+      const uint32_t lost = historySeq - c.seq - TELEMETRY_HISTORY;
+      c.dropped += AtClientRate(c, lost);
+      c.seq = historySeq - TELEMETRY_HISTORY;
+    }
+
+    // A sample is kept once the client's interval has (nearly) passed since the last kept one,
+    // so sampling jitter does not turn every other sample into every third
+    const uint32_t minGapUs = c.intervalUs - TELEMETRY_SAMPLE_US / 2;
+    size_t count = 0;
+    uint8_t *p = frame + TELEMETRY_HEADER_BYTES;
+    for (; c.seq != historySeq; ++c.seq)
+    {
+      const TelemetrySample &s = history[c.seq & (TELEMETRY_HISTORY - 1)];
+      if (c.kept && s.timeUs - c.lastKeptUs < minGapUs)
+        continue;
+      c.kept = true;
+      c.lastKeptUs = s.timeUs;
+      Put32(p, s.timeUs);
+      Put16(p + 4, s.in1);
+      Put16(p + 6, s.in2);
+      p[8] = s.phase;
+      p[9] = s.flags;
+      p += TELEMETRY_RECORD_BYTES;
+      ++count;
+    }
+    if (count == 0 && c.dropped == 0)
+      return 0;
+
+    frame[0] = TELEMETRY_FRAME_KIND;
+    frame[1] = (uint8_t)TELEMETRY_RECORD_BYTES;
+    Put16(frame + 2, (uint16_t)count);
+    Put16(frame + 4, dutyMax);
+    Put16(frame + 6, (uint16_t)(c.dropped > 0xFFFF ? 0xFFFF : c.dropped));
+    return TELEMETRY_HEADER_BYTES + count * TELEMETRY_RECORD_BYTES;
+  }
+} // namespace
+
+bool TelemetryDue(uint32_t nowUs)
+{
+  if (!enabled.load(std::memory_order_relaxed))
+    return false;
+  const uint32_t since = nowUs - lastSampleUs;
+  if (since < TELEMETRY_SAMPLE_US)
+    return false;
+  // Stay on the sampling grid unless a late call has already skipped a whole period
+  lastSampleUs = since < 2 * TELEMETRY_SAMPLE_US ? lastSampleUs + TELEMETRY_SAMPLE_US : nowUs;
+  return true;
+}
+
+void TelemetryRecord(const TelemetrySample &sample)
+{
+  samplesTaken.store(samplesTaken.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  TelemetrySample *slot = ring.Claim();
+  if (!slot)
+  {
+    overrun = true;
+    overruns.store(overruns.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    return;
+  }
+  *slot = sample;
+  if (overrun)
+    slot->flags |= TELEMETRY_GAP;
+  overrun = false;
+  ring.Publish();
+}
+
+bool TelemetrySubscribe(uint32_t clientId, uint32_t hz, uint32_t nowMs)
+{
+  Client *c = Find(clientId);
+  if (hz == 0)
+  {
+    if (c)
+      c->used = false;
+    UpdateEnabled();
+    return true;
+  }
+  for (size_t i = 0; !c && i < STATUS_MAX_CLIENTS; ++i)
+  {
+    if (!clients[i].used)
+    {
+      c = &clients[i];
+      *c = Client{};
+      c->id = clientId;
+      c->used = true;
+      c->seq = historySeq;
+      c->lastFrameMs = nowMs;
+    }
+  }
+  if (!c)
+    return false;
+  const uint32_t intervalUs = 1000000u / hz;
+  c->intervalUs = intervalUs > TELEMETRY_SAMPLE_US ? intervalUs : TELEMETRY_SAMPLE_US;
+  UpdateEnabled();
+  return true;
+}
+
+void TelemetryRemoveClient(uint32_t clientId)
+{
+  if (Client *c = Find(clientId))
+  {
+    c->used = false;
+    UpdateEnabled();
+  }
+}
+
+void TelemetryPump(uint32_t nowMs, TelemetrySendFn send)
+{
+  TelemetrySample s;
+  while (ring.Pop(s))
+    history[historySeq++ & (TELEMETRY_HISTORY - 1)] = s;
+
+  uint16_t dutyMax = 0; // read once, and only if a frame goes out
+  for (Client &c : clients)
+  {
+    if (!c.used || nowMs - c.lastFrameMs < TELEMETRY_BATCH_MS)
+      continue;
+    c.lastFrameMs = nowMs;
+    if (dutyMax == 0)
+    {
+      ProcessorStatus st;
+      uint32_t version;
+      dutyMax = ProcessorGetStatus(st, version) ? st.dutyMax : 0xFFFF;
+    }
+    const size_t len = BuildFrame(c, dutyMax);
+    if (len == 0)
+      continue;
+    const uint32_t count = (uint32_t)((len - TELEMETRY_HEADER_BYTES) / TELEMETRY_RECORD_BYTES);
+    if (send(c.id, frame, len))
+      c.dropped = 0;
+    else
+      c.dropped += count;
+  }
+}
+
+TelemetryStats TelemetryGetStats()
+{
+  uint32_t subscribers = 0;
+  for (const Client &c : clients)
+    subscribers += c.used;
+  return TelemetryStats{samplesTaken.load(std::memory_order_relaxed), overruns.load(std::memory_order_relaxed), subscribers};
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+// Binary duty/phase telemetry for tuning ramps. While at least one client listens,
+// ServiceProcessor() takes a sample every TELEMETRY_SAMPLE_US (200 Hz by default) into a lock-free
+// ring; loop() moves the samples into a short shared history and sends each subscriber one binary
+// frame every TELEMETRY_BATCH_MS, decimated on the device to the rate it asked for.
+//
+// Frame layout, little-endian:
+//   header  u8 kind (TELEMETRY_FRAME_KIND), u8 record bytes, u16 count, u16 duty max, u16 dropped
+//   record  u32 time (us, wraps), u16 IN1 duty, u16 IN2 duty, u8 phase (ProcessorPhase), u8 flags
+// "dropped" counts records this client missed since its previous frame. Telemetry is live data: a
+// frame its link refuses is dropped, never queued.
+
+#include <stdint.h>
+#include <stddef.h>
+#include "status_channel.h" // STATUS_MAX_CLIENTS
+
+#ifndef TELEMETRY_SAMPLE_US
+  #define TELEMETRY_SAMPLE_US 5000 // sampling period, and the finest rate a client can ask for
+#endif
+
+#ifndef TELEMETRY_BATCH_MS
+  #define TELEMETRY_BATCH_MS 50 // one frame per client per period
+#endif
+
+#ifndef TELEMETRY_HISTORY
+  #define TELEMETRY_HISTORY 64 // samples kept for the batches (power of two)
+#endif
+
+constexpr uint8_t TELEMETRY_FRAME_KIND = 0x01;
+constexpr size_t TELEMETRY_HEADER_BYTES = 8;
+constexpr size_t TELEMETRY_RECORD_BYTES = 10;
+constexpr size_t TELEMETRY_FRAME_BYTES = TELEMETRY_HEADER_BYTES + TELEMETRY_HISTORY * TELEMETRY_RECORD_BYTES;
+
+static_assert((TELEMETRY_HISTORY & (TELEMETRY_HISTORY - 1)) == 0, "TELEMETRY_HISTORY must be a power of two");
+static_assert(TELEMETRY_HISTORY * TELEMETRY_SAMPLE_US >= 2000u * TELEMETRY_BATCH_MS,
+              "telemetry history must hold two batches");
+
+enum TelemetryFlag : uint8_t {
+  TELEMETRY_RUNNING = 1u << 0, // auto cycle on
+  TELEMETRY_FORWARD = 1u << 1, // direction of the last drive
+  TELEMETRY_FADING  = 1u << 2, // hardware fade: the driven leg's duty is interpolated
+  TELEMETRY_UNKNOWN = 1u << 3, // a leg's duty is not known (a fade stopped midway); sent as 0xFFFF
+  TELEMETRY_GAP     = 1u << 4  // samples were lost just before this one (ring full)
+};
+
+struct TelemetrySample
+{
+  uint32_t timeUs;
+  uint16_t in1;
+  uint16_t in2;
+  uint8_t phase;
+  uint8_t flags;
+};
+
+// Processor side (whichever thread runs ServiceProcessor()). TelemetryDue() is a relaxed load and
+// a compare while nobody listens.
+bool TelemetryDue(uint32_t nowUs);
+void TelemetryRecord(const TelemetrySample &sample);
+
+// Everything below is called from one thread (loop()).
+
+// Starts, changes (hz) or stops (0) a client's stream; rates above the sampling rate are clamped.
+// False if no slot is free.
+bool TelemetrySubscribe(uint32_t clientId, uint32_t hz, uint32_t nowMs);
+void TelemetryRemoveClient(uint32_t clientId);
+
+// Sends one binary frame; false if it was not sent
+typedef bool (*TelemetrySendFn)(uint32_t clientId, const uint8_t *data, size_t len);
+
+// Collects new samples and sends each subscriber its batch when due; call every loop() pass
+void TelemetryPump(uint32_t nowMs, TelemetrySendFn send);
+
+struct TelemetryStats
+{
+  uint32_t samples;     // taken
+  uint32_t overruns;    // lost because loop() fell behind
+  uint32_t subscribers;
+};
+TelemetryStats TelemetryGetStats();
@@ -0,0 +1,292 @@
+#include "trace.h"
+#include "json_writer.h"
+#include "processor.h"
+#include <string.h>
+
+namespace
+{
+  // A disabled build keeps the API (an empty export) without the ring's RAM
+  constexpr uint32_t SLOTS = ENABLE_TRACE ? TRACE_EVENTS : 1;
+
+  // Per-slot sequence lock: seq is 0 while the slot is being written, then index + 1
+  struct Slot
+  {
+    std::atomic<uint32_t> seq;
+    std::atomic<uint32_t> timeUs;
+    std::atomic<uint32_t> packed; // type | a << 8 | b << 16
+    std::atomic<uint32_t> c;
+  };
+  Slot ring[SLOTS];
+  std::atomic<uint32_t> head{0}; // index of the next event
+
+  struct Record
+  {
+    uint32_t timeUs;
+    uint32_t packed;
+    uint32_t c;
+  };
+
+  // False if event i has been overwritten or is being written right now
+  bool ReadSlot(uint32_t i, Record &out)
+  {
+    const Slot &s = ring[i & (SLOTS - 1)];
+    const uint32_t seq = s.seq.load(std::memory_order_acquire);
+    if (seq != i + 1)
+      return false;
+    out.timeUs = s.timeUs.load(std::memory_order_relaxed);
+    out.packed = s.packed.load(std::memory_order_relaxed);
+    out.c = s.c.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return s.seq.load(std::memory_order_relaxed) == seq;
+  }
+
+  // Perfetto tracks (tid); PWM duties are process-wide counters
+  enum Track : uint8_t { PHASE_TRACK = 1, RAMP_TRACK, BUTTON_TRACK, COMMAND_TRACK, WS_TRACK };
+  const char *const TRACK_NAMES[] = {"phase", "ramp", "buttons", "commands", "websocket"};
+  constexpr uint8_t TRACKS = sizeof(TRACK_NAMES) / sizeof(TRACK_NAMES[0]);
+
+  const char *const COMMAND_NAMES[] = {"MANUAL_FWD", "MANUAL_REV", "COAST_STOP", "BRAKE_STOP", "AUTO_START",
+                                       "SET_CRUISE", "PRINT_STATE", "TEST_IN1", "TEST_IN2", "ALL_OFF",
+                                       "SET_FORWARD_MS", "SET_REVERSE_MS", "SET_RAMP_UP_MS", "SET_RAMP_DOWN_MS",
+                                       "SET_COAST_MS", "SET_RAMP_PROFILE"};
+  static_assert(sizeof(COMMAND_NAMES) / sizeof(COMMAND_NAMES[0]) == (size_t)ProcessorCommand::SET_RAMP_PROFILE + 1,
+                "command name table out of sync");
+
+  // {"name":...,"ph":...,"pid":1,"tid":...,"ts":...; the caller adds args and closes it
+  JsonWriter &Begin(JsonWriter &w, const char *name, const char *ph, uint8_t tid, uint32_t ts)
+  {
+    w.BeginObject().Field("name", name).Field("ph", ph).Key("pid").Uint(1);
+    if (tid)
+      w.Key("tid").Uint(tid);
+    w.Key("ts").Uint(ts);
+    if (ph[0] == 'i')
+      w.Field("s", "t"); // instant scoped to its track
+    return w;
+  }
+} // namespace
+
+void TraceEmitAt(uint32_t timeUs, TraceEvent event, uint8_t a, uint16_t b, uint32_t c)
+{
+#if defined(ESP8266)
+  // Callbacks never preempt loop() there, so a plain increment cannot lose a race
+  const uint32_t i = head.load(std::memory_order_relaxed);
+  head.store(i + 1, std::memory_order_relaxed);
+#else
+  const uint32_t i = head.fetch_add(1, std::memory_order_relaxed);
+#endif
+  Slot &s = ring[i & (SLOTS - 1)];
+  s.seq.store(0, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  s.timeUs.store(timeUs, std::memory_order_relaxed);
+  s.packed.store((uint32_t)event | (uint32_t)a << 8 | (uint32_t)b << 16, std::memory_order_relaxed);
+  s.c.store(c, std::memory_order_relaxed);
+  s.seq.store(i + 1, std::memory_order_release);
+}
+
+TraceStats TraceGetStats()
+{
+  return TraceStats{head.load(std::memory_order_relaxed), ENABLE_TRACE ? SLOTS : 0};
+}
+
+TraceChromeWriter::TraceChromeWriter()
+{
+  end_ = ENABLE_TRACE ? head.load(std::memory_order_acquire) : 0;
+  next_ = end_ > SLOTS ? end_ - SLOTS : 0;
+  // Timestamps are made relative to the oldest event (signed compare: the ring spans far less
+  // than the 71 minutes it takes micros() to wrap)
+  bool any = false;
+  baseUs_ = 0;
+  for (uint32_t i = next_; i != end_; ++i)
+  {
+    Record r;
+    if (!ReadSlot(i, r))
+      continue;
+    if (!any || (int32_t)(r.timeUs - baseUs_) < 0)
+      baseUs_ = r.timeUs;
+    any = true;
+  }
+}
+
+size_t TraceChromeWriter::Fill(char *out, size_t cap)
+{
+  size_t written = 0;
+  while (written < cap)
+  {
+    if (lineOff_ == lineLen_ && !NextLine())
+      break;
+    size_t chunk = lineLen_ - lineOff_;
+    if (chunk > cap - written)
+      chunk = cap - written;
+    memcpy(out + written, line_ + lineOff_, chunk);
+    lineOff_ += chunk;
+    written += chunk;
+  }
+  return written;
+}
+
+bool TraceChromeWriter::NextLine()
+{
+  lineLen_ = 0;
+  lineOff_ = 0;
+  if (step_ == 0)
+  {
+    JsonWriter w(line_, sizeof(line_));
+    w.BeginObject().Field("displayTimeUnit", "ms").Key("otherData").BeginObject();
+    w.Key("base_us").Uint(baseUs_).Key("recorded").Uint(end_).Key("capacity").Uint(ENABLE_TRACE ? SLOTS : 0);
+    w.EndObject().Key("traceEvents").BeginArray();
+    lineLen_ = w.Length(); // left open: the events follow
+    ++step_;
+    return true;
+  }
+  if (step_ <= TRACKS)
+  {
+    // Track names
+    JsonWriter w(line_ + 1, sizeof(line_) - 1);
+    w.BeginObject().Field("name", "thread_name").Field("ph", "M").Key("pid").Uint(1).Key("tid").Uint(step_);
+    w.Key("args").BeginObject().Field("name", TRACK_NAMES[step_ - 1]).EndObject().EndObject();
+    line_[0] = ',';
+    lineLen_ = w.Length() + 1;
+    if (first_)
+    {
+      first_ = false;
+      lineOff_ = 1;
+    }
+    ++step_;
+    return true;
+  }
+  if (step_ == TRACKS + 1)
+  {
+    while (next_ != end_)
+    {
+      Record r;
+      const uint32_t i = next_++;
+      if (!ReadSlot(i, r))
+        continue;
+      WriteEvent(r.timeUs, (uint8_t)r.packed, (uint8_t)(r.packed >> 8), (uint16_t)(r.packed >> 16), r.c);
+      if (lineLen_ > 0)
+        return true;
+    }
+    ++step_;
+  }
+  if (step_ == TRACKS + 2)
+  {
+    memcpy(line_, "]}\n", 3);
+    lineLen_ = 3;
+    ++step_;
+    return true;
+  }
+  return false;
+}
+
+// One trace event (two for a phase change: the end of the previous slice, then the new one) as
+// ",{...}" into line_; lineLen_ stays 0 for events that produce nothing
+void TraceChromeWriter::WriteEvent(uint32_t timeUs, uint8_t type, uint8_t a, uint16_t b, uint32_t c)
+{
+  const uint32_t ts = timeUs - baseUs_;
+  size_t len = 0;
+  auto emit = [&](JsonWriter &w)
+  {
+    w.EndObject();
+    if (!w.Ok())
+      return;
+    line_[len] = ',';
+    len += w.Length() + 1;
+  };
+
+  switch ((TraceEvent)type)
+  {
+    case TraceEvent::PHASE:
+    {
+      if (phaseOpen_)
+      {
+        JsonWriter w(line_ + len + 1, sizeof(line_) - len - 1);
+        Begin(w, ProcessorPhaseName((ProcessorPhase)b), "E", PHASE_TRACK, ts);
+        emit(w);
+      }
+      JsonWriter w(line_ + len + 1, sizeof(line_) - len - 1);
+      Begin(w, ProcessorPhaseName((ProcessorPhase)a), "B", PHASE_TRACK, ts);
+      emit(w);
+      phaseOpen_ = true;
+      break;
+    }
+    case TraceEvent::RAMP_START:
+    {
+      JsonWriter w(line_ + 1, sizeof(line_) - 1);
+      Begin(w, (a & TRACE_RAMP_FORWARD) ? "ramp IN1" : "ramp IN2", "B", RAMP_TRACK, ts);
+      w.Key("args").BeginObject().Key("from").Uint(c & 0xFFFF).Key("to").Uint(b).Key("ms").Uint(c >> 16);
+      w.Key("hardware").Bool(a & TRACE_RAMP_HARDWARE).EndObject();
+      emit(w);
+      rampOpen_ = true;
+      break;
+    }
+    case TraceEvent::RAMP_END:
+    {
+      if (rampOpen_)
+      {
+        JsonWriter w(line_ + 1, sizeof(line_) - 1);
+        Begin(w, (a & TRACE_RAMP_FORWARD) ? "ramp IN1" : "ramp IN2", "E", RAMP_TRACK, ts);
+        w.Key("args").BeginObject();
+        if (b != 0xFFFF)
+          w.Key("final").Uint(b);
+        w.Key("cancelled").Bool(a & TRACE_RAMP_CANCELLED).Key("timeout").Bool(a & TRACE_RAMP_TIMEOUT).EndObject();
+        emit(w);
+        rampOpen_ = false;
+      }
+      if ((a & TRACE_RAMP_HARDWARE) && b != 0xFFFF)
+      {
+        // The fade engine's writes are not traced; show where it ended up
+        JsonWriter w(line_ + len + 1, sizeof(line_) - len - 1);
+        Begin(w, (a & TRACE_RAMP_FORWARD) ? "IN1" : "IN2", "C", 0, ts);
+        w.Key("args").BeginObject().Key("duty").Uint(b).EndObject();
+        emit(w);
+      }
+      break;
+    }
+    case TraceEvent::PWM:
+    {
+      JsonWriter w(line_ + 1, sizeof(line_) - 1);
+      Begin(w, (a & ~TRACE_PWM_FADE) == 1 ? "IN1" : "IN2", "C", 0, ts);
+      w.Key("args").BeginObject().Key("duty").Uint(c).EndObject();
+      emit(w);
+      break;
+    }
+    case TraceEvent::BUTTON:
+    {
+      JsonWriter w(line_ + 1, sizeof(line_) - 1);
+      Begin(w, b ? "button up" : "button down", "i", BUTTON_TRACK, ts);
+      w.Key("args").BeginObject().Key("button").Uint(a).EndObject();
+      emit(w);
+      break;
+    }
+    case TraceEvent::COMMAND:
+    {
+      float arg;
+      memcpy(&arg, &c, sizeof(arg));
+      JsonWriter w(line_ + 1, sizeof(line_) - 1);
+      Begin(w, a < sizeof(COMMAND_NAMES) / sizeof(COMMAND_NAMES[0]) ? COMMAND_NAMES[a] : "?", "i", COMMAND_TRACK, ts);
+      w.Key("args").BeginObject().Field("source", (b & 0xFF) == (uint8_t)CommandSource::NETWORK ? "network" : "console");
+      w.Key("arg").Fixed((int64_t)(arg * 1000.0f + (arg < 0 ? -0.5f : 0.5f)), 3);
+      w.Key("rejected").Bool(b & TRACE_COMMAND_REJECTED).EndObject();
+      emit(w);
+      break;
+    }
+    case TraceEvent::WS_SEND:
+    {
+      JsonWriter w(line_ + 1, sizeof(line_) - 1);
+      Begin(w, (a & TRACE_WS_REFUSED) ? "ws refused" : "ws send", "i", WS_TRACK, ts);
+      w.Key("args").BeginObject().Key("client").Uint(c).Key("bytes").Uint(b);
+      w.Key("binary").Bool(a & TRACE_WS_BINARY).EndObject();
+      emit(w);
+      break;
+    }
+    default:
+      break;
+  }
+
+  lineLen_ = len;
+  if (len > 0 && first_)
+  {
+    first_ = false;
+    lineOff_ = 1; // no comma before the first event
+  }
+}
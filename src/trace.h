@@ -0,0 +1,102 @@
+#pragma once
+
+// Binary event trace: a fixed ring of 16-byte records (microsecond timestamp, event type, three
+// small arguments) that the motor path, buttons, command queue and WebSocket outbox write into as
+// things happen. Recording claims a slot with one atomic increment and stores four words, with no
+// locks, formatting or allocation, so it stays on in production like the metrics; -D ENABLE_TRACE=0
+// compiles every TRACE() out. The ring keeps the newest TRACE_EVENTS events, and
+// TraceChromeWriter turns them into Chrome Trace Event JSON (/api/trace, the native `trace`
+// command) for Perfetto or chrome://tracing.
+
+#include "hal.h"
+#include <atomic>
+
+#ifndef ENABLE_TRACE
+  #define ENABLE_TRACE 1
+#endif
+
+#ifndef TRACE_EVENTS
+  #if defined(ESP8266)
+    #define TRACE_EVENTS 256 // ring size in events, power of two (16 bytes each)
+  #else
+    #define TRACE_EVENTS 1024
+  #endif
+#endif
+
+static_assert((TRACE_EVENTS & (TRACE_EVENTS - 1)) == 0, "TRACE_EVENTS must be a power of two");
+
+// Argument layout per event: a (8 bits), b (16 bits), c (32 bits)
+enum class TraceEvent : uint8_t {
+  PHASE,      // a = new ProcessorPhase, b = previous one
+  RAMP_START, // a = TraceRampFlags, b = target duty, c = from duty | ms << 16
+  RAMP_END,   // a = TraceRampFlags, b = final duty (0xFFFF: unknown, a fade stopped midway)
+  PWM,        // a = leg (1: IN1, 2: IN2) | TRACE_PWM_FADE, c = duty (the fade's start for a fade)
+  BUTTON,     // a = button index, b = level after the edge (1: released); timestamp of the edge
+  COMMAND,    // a = ProcessorCommand, b = CommandSource | TRACE_COMMAND_REJECTED, c = arg (float bits)
+  WS_SEND     // a = TraceWsFlags, b = bytes (saturated), c = client id
+};
+
+enum TraceRampFlags : uint8_t {
+  TRACE_RAMP_FORWARD   = 1u << 0,
+  TRACE_RAMP_HARDWARE  = 1u << 1, // run by the fade engine
+  TRACE_RAMP_CANCELLED = 1u << 2, // cut short by a command or a new ramp
+  TRACE_RAMP_TIMEOUT   = 1u << 3  // fade completion interrupt never came; target forced
+};
+
+constexpr uint8_t TRACE_PWM_FADE = 0x80;          // leg handed to the fade engine
+constexpr uint16_t TRACE_COMMAND_REJECTED = 0x100; // queue was full
+
+enum TraceWsFlags : uint8_t {
+  TRACE_WS_BINARY  = 1u << 0,
+  TRACE_WS_REFUSED = 1u << 1 // send queue full; not sent
+};
+
+// Any thread (not interrupts). Events may be recorded out of timestamp order (e.g. button edges
+// are stamped in the ISR and recorded when consumed); the export does not depend on order.
+void TraceEmitAt(uint32_t timeUs, TraceEvent event, uint8_t a = 0, uint16_t b = 0, uint32_t c = 0);
+inline void TraceEmit(TraceEvent event, uint8_t a = 0, uint16_t b = 0, uint32_t c = 0)
+{
+  TraceEmitAt(hal::Micros(), event, a, b, c);
+}
+
+#if ENABLE_TRACE
+  #define TRACE(...) TraceEmit(__VA_ARGS__)
+  #define TRACE_AT(...) TraceEmitAt(__VA_ARGS__)
+#else
+  #define TRACE(...) do { } while (0)
+  #define TRACE_AT(...) do { } while (0)
+#endif
+
+struct TraceStats
+{
+  uint32_t recorded; // since boot (wraps)
+  uint32_t capacity;
+};
+TraceStats TraceGetStats();
+
+// Chrome Trace Event JSON ({"traceEvents":[...]}) of the ring, a piece at a time into caller
+// buffers like MetricsPrometheusWriter. The range is fixed on construction; events overwritten
+// while the export runs are skipped. Phases and ramps become slices, PWM duties counters, the rest
+// instant events; timestamps are microseconds from the oldest event (its device time is in
+// otherData.base_us).
+class TraceChromeWriter
+{
+public:
+  TraceChromeWriter();
+  size_t Fill(char *out, size_t cap); // bytes written; 0 once everything has been written
+
+private:
+  bool NextLine();
+  void WriteEvent(uint32_t timeUs, uint8_t type, uint8_t a, uint16_t b, uint32_t c);
+
+  uint32_t next_;
+  uint32_t end_;
+  uint32_t baseUs_;
+  uint8_t step_ = 0;            // 0: header, 1: events, 2: footer, 3: done
+  bool phaseOpen_ = false;      // a phase slice has been begun (its end is only written then)
+  bool rampOpen_ = false;
+  bool first_ = true;           // no event written yet (comma handling)
+  char line_[320];
+  size_t lineLen_ = 0;
+  size_t lineOff_ = 0;
+};
@@ -31,6 +31,9 @@ inline const char *getDashboardHTML()
                     input[type="number"] { width: 90px; padding: 6px 8px; border-radius: 4px; border: 1px solid #bbb; }
                     #log { background: #1e1e1e; color: #8ef58e; padding: 10px; min-height: 200px; max-height: 260px; overflow-y: auto; font-family: "Fira Code", monospace; font-size: 12px; border-radius: 6px; margin-top: 8px; }
                     #log div { margin-bottom: 4px; }
+                    select { padding: 6px 8px; border-radius: 4px; border: 1px solid #bbb; }
+                    #trace { width: 100%; height: 160px; background: #1e1e1e; border-radius: 6px; display: block; }
+                    .legend { font-size: 12px; color: #666; }
                     a { color: #1976d2; text-decoration: none; }
                     a:hover { text-decoration: underline; }
                 </style>
@@ -40,7 +43,12 @@ inline const char *getDashboardHTML()
                     <h1>&#x1F3AC; Rollfilm Rotator</h1>
                     <div class="status"><span>Uptime:</span><span id="uptime">-</span></div>
                     <div class="status"><span>Free Heap:</span><span id="heap">-</span></div>
+                    <div class="status"><span>Heap Fragmentation:</span><span id="heapFrag">-</span></div>
                     <div class="status"><span>WiFi RSSI:</span><span id="rssi">-</span></div>
+                    <div class="status"><span>Phase:</span><span id="phase">-</span></div>
+                    <div class="status"><span>Motor:</span><span id="motor">-</span></div>
+                    <div class="status"><span>Cruise:</span><span id="cruise">-</span></div>
+                    <div class="status"><span>Timings:</span><span id="timings">-</span></div>
                     
                     <h3>Motor Control</h3>
                     <div class="button-row">
@@ -69,7 +77,21 @@ inline const char *getDashboardHTML()
                         <button class="button outline" onclick="sendCommand('test_in1')">Test IN1 (Forward)</button>
                         <button class="button outline" onclick="sendCommand('test_in2')">Test IN2 (Reverse)</button>
                     </div>
-                    
+
+                    <h3>Duty Trace</h3>
+                    <div class="form-row">
+                        <label for="traceRate">Rate</label>
+                        <select id="traceRate" onchange="if (trace.on) sendCommand('telemetry', this.value)">
+                            <option value="50">50 Hz</option>
+                            <option value="100" selected>100 Hz</option>
+                            <option value="200">200 Hz</option>
+                        </select>
+                        <button class="button outline" id="traceToggle" onclick="toggleTrace()">Start Trace</button>
+                        <span class="legend"><span style="color:#4fc3f7">IN1</span> / <span style="color:#ff8a65">IN2</span> duty, last 5 s; shading = phase</span>
+                        <span class="legend" id="traceInfo"></span>
+                    </div>
+                    <canvas id="trace" width="672" height="160"></canvas>
+
                     <h3>Live Log</h3>
                     <div id="log"></div>
                     
@@ -77,10 +99,35 @@ inline const char *getDashboardHTML()
                 </div>
 
                 <script>
-                    const ws = new WebSocket('ws://' + window.location.host + '/ws');
+                    let ws = null;
+                    let lastLogTs = -1; // device timestamp of the newest log line shown
+                    let reconnectDelay = 1000;
                     const log = document.getElementById('log');
                     const MAX_LOG_LINES = 200;
                     const cruiseInput = document.getElementById('cruiseInput');
+                    const state = {}; // motor state, patched by 'state' deltas
+
+                    // Duty trace: binary telemetry frames decoded into typed-array rings
+                    const TRACE_SAMPLES = 2048; // ~10 s at 200 Hz
+                    const TRACE_WINDOW_MS = 5000;
+                    const PHASE_SHADES = ['#1e1e1e', '#24352a', '#2a3a24', '#24303f', '#3a3224', '#2c2c2c', '#3f2424']; // by phase, IDLE..STOPPING
+                    const trace = {
+                        t: new Float64Array(TRACE_SAMPLES),  // ms on the device clock, unwrapped
+                        in1: new Float32Array(TRACE_SAMPLES), // % of duty max; NaN = unknown
+                        in2: new Float32Array(TRACE_SAMPLES),
+                        phase: new Uint8Array(TRACE_SAMPLES),
+                        head: 0, count: 0, lastUs: -1, ms: 0, dropped: 0, on: false, drawPending: false
+                    };
+                    const traceCanvas = document.getElementById('trace');
+
+                    function renderState() {
+                        document.getElementById('phase').textContent = state.phase + (state.running ? ' (auto)' : '');
+                        const pct = state.duty_max ? (100 * state.duty / state.duty_max).toFixed(1) : '-';
+                        document.getElementById('motor').textContent = state.dir + ' ' + pct + '% (duty ' + state.duty + ')';
+                        document.getElementById('cruise').textContent = state.cruise + '%';
+                        document.getElementById('timings').textContent = 'fwd ' + state.fwd_ms + ' / rev ' + state.rev_ms +
+                            ' ms, ramp ' + state.ramp_up_ms + '/' + state.ramp_down_ms + ' ms (' + state.profile + '), coast ' + state.coast_ms + ' ms';
+                    }
 
                     function appendLogLine(text) {
                         const entry = document.createElement('div');
@@ -92,17 +139,130 @@ inline const char *getDashboardHTML()
                         log.scrollTop = log.scrollHeight;
                     }
 
-                    ws.onmessage = function(event) {
+                    function appendDeviceLog(timestamp, message) {
+                        const deviceTime = (timestamp / 1000).toFixed(1) + 's';
+                        appendLogLine('[' + deviceTime + '] ' + message);
+                        lastLogTs = timestamp;
+                    }
+
+                    function resetTrace() {
+                        trace.head = 0;
+                        trace.count = 0;
+                        trace.lastUs = -1;
+                        trace.dropped = 0;
+                    }
+
+                    // Frame: u8 kind, u8 record bytes, u16 count, u16 duty max, u16 dropped, then records of
+                    // u32 time (us), u16 IN1, u16 IN2, u8 phase, u8 flags; all little-endian (see telemetry.h)
+                    function onTelemetry(buf) {
+                        const v = new DataView(buf);
+                        if (v.byteLength < 8 || v.getUint8(0) !== 1) {
+                            return;
+                        }
+                        const size = v.getUint8(1);
+                        const count = v.getUint16(2, true);
+                        const dutyMax = v.getUint16(4, true) || 1;
+                        trace.dropped += v.getUint16(6, true);
+                        for (let i = 0, o = 8; i < count && o + size <= v.byteLength; i++, o += size) {
+                            const us = v.getUint32(o, true);
+                            if (trace.lastUs >= 0) {
+                                trace.ms += ((us - trace.lastUs) >>> 0) / 1000; // the counter wraps every ~71 min
+                            }
+                            trace.lastUs = us;
+                            const d1 = v.getUint16(o + 4, true);
+                            const d2 = v.getUint16(o + 6, true);
+                            const j = trace.head;
+                            trace.t[j] = trace.ms;
+                            trace.in1[j] = d1 > dutyMax ? NaN : 100 * d1 / dutyMax;
+                            trace.in2[j] = d2 > dutyMax ? NaN : 100 * d2 / dutyMax;
+                            trace.phase[j] = v.getUint8(o + 8);
+                            trace.head = (j + 1) % TRACE_SAMPLES;
+                            trace.count = Math.min(trace.count + 1, TRACE_SAMPLES);
+                        }
+                        if (!trace.drawPending) {
+                            trace.drawPending = true;
+                            requestAnimationFrame(drawTrace);
+                        }
+                    }
+
+                    function drawTrace() {
+                        trace.drawPending = false;
+                        const g = traceCanvas.getContext('2d');
+                        const w = traceCanvas.width, h = traceCanvas.height;
+                        g.fillStyle = PHASE_SHADES[0];
+                        g.fillRect(0, 0, w, h);
+                        document.getElementById('traceInfo').textContent = trace.dropped ? trace.dropped + ' samples dropped' : '';
+                        if (trace.count === 0) {
+                            return;
+                        }
+                        const first = (trace.head + TRACE_SAMPLES - trace.count) % TRACE_SAMPLES;
+                        const newest = trace.t[(trace.head + TRACE_SAMPLES - 1) % TRACE_SAMPLES];
+                        const x = function(t) { return (t - newest + TRACE_WINDOW_MS) * w / TRACE_WINDOW_MS; };
+                        const y = function(pct) { return h - 2 - (h - 4) * pct / 100; };
+                        // Phase shading, each sample up to the next
+                        for (let k = 0; k + 1 < trace.count; k++) {
+                            const j = (first + k) % TRACE_SAMPLES, n = (j + 1) % TRACE_SAMPLES;
+                            if (trace.t[n] < newest - TRACE_WINDOW_MS) {
+                                continue;
+                            }
+                            g.fillStyle = PHASE_SHADES[trace.phase[j]] || PHASE_SHADES[0];
+                            g.fillRect(x(trace.t[j]), 0, x(trace.t[n]) - x(trace.t[j]) + 1, h);
+                        }
+                        [[trace.in1, '#4fc3f7'], [trace.in2, '#ff8a65']].forEach(function(leg) {
+                            const values = leg[0];
+                            g.strokeStyle = leg[1];
+                            g.lineWidth = 1.5;
+                            g.beginPath();
+                            let pen = false;
+                            for (let k = 0; k < trace.count; k++) {
+                                const j = (first + k) % TRACE_SAMPLES;
+                                if (trace.t[j] < newest - TRACE_WINDOW_MS || isNaN(values[j])) {
+                                    pen = false;
+                                    continue;
+                                }
+                                if (pen) {
+                                    g.lineTo(x(trace.t[j]), y(values[j]));
+                                } else {
+                                    g.moveTo(x(trace.t[j]), y(values[j]));
+                                }
+                                pen = true;
+                            }
+                            g.stroke();
+                        });
+                    }
+
+                    function toggleTrace() {
+                        trace.on = !trace.on;
+                        document.getElementById('traceToggle').textContent = trace.on ? 'Stop Trace' : 'Start Trace';
+                        if (trace.on) {
+                            resetTrace();
+                        }
+                        sendCommand('telemetry', trace.on ? document.getElementById('traceRate').value : 0);
+                    }
+
+                    function onMessage(event) {
+                        if (typeof event.data !== 'string') {
+                            onTelemetry(event.data);
+                            return;
+                        }
                         const data = JSON.parse(event.data);
                         if (data.type === 'status') {
                             document.getElementById('uptime').textContent = (data.uptime / 1000).toFixed(1) + 's';
                             document.getElementById('heap').textContent = data.heap + ' bytes';
+                            document.getElementById('heapFrag').textContent = data.heap_frag + '% (largest block ' + data.heap_max_block + ' bytes)';
                             document.getElementById('rssi').textContent = data.wifi_rssi + ' dBm';
+                        } else if (data.type === 'state') {
+                            Object.assign(state, data);
+                            renderState();
                         } else if (data.type === 'log') {
-                            const deviceTime = (data.timestamp / 1000).toFixed(1) + 's';
-                            appendLogLine('[' + deviceTime + '] ' + data.message);
+                            appendDeviceLog(data.timestamp, data.message);
+                        } else if (data.type === 'log_batch') {
+                            if (data.dropped) {
+                                appendLogLine('... ' + data.dropped + ' log lines dropped (connection too slow)');
+                            }
+                            data.entries.forEach(function(e) { appendDeviceLog(e[0], e[1]); });
                         }
-                    };
+                    }
 
                     function sendCommand(cmd, value) {
                         let message = cmd;
@@ -128,13 +288,29 @@ inline const char *getDashboardHTML()
                         sendCommand('set_cruise', clamped);
                     }
 
-                    ws.onopen = function() {
-                        appendLogLine(new Date().toLocaleTimeString() + ' - Connected to device');
-                    };
+                    function connect() {
+                        ws = new WebSocket('ws://' + window.location.host + '/ws');
+                        ws.binaryType = 'arraybuffer'; // telemetry frames
+                        ws.onmessage = onMessage;
+                        ws.onopen = function() {
+                            appendLogLine(new Date().toLocaleTimeString() + ' - Connected to device');
+                            reconnectDelay = 1000;
+                            // Only pull the history we haven't shown yet
+                            ws.send(lastLogTs < 0 ? 'history' : 'history_since=' + lastLogTs);
+                            ws.send('subscribe metrics 0'); // state and status arrive by default; metrics aren't shown
+                            if (trace.on) {
+                                resetTrace(); // the device may have rebooted; start a fresh timeline
+                                ws.send('telemetry=' + document.getElementById('traceRate').value);
+                            }
+                        };
+                        ws.onclose = function() {
+                            appendLogLine(new Date().toLocaleTimeString() + ' - Connection closed, retrying in ' + (reconnectDelay / 1000) + 's');
+                            setTimeout(connect, reconnectDelay);
+                            reconnectDelay = Math.min(reconnectDelay * 2, 30000);
+                        };
+                    }
 
-                    ws.onclose = function() {
-                        appendLogLine(new Date().toLocaleTimeString() + ' - Connection closed');
-                    };
+                    connect();
                 </script>
             </body>
             </html>
@@ -0,0 +1,349 @@
+#include "ws_outbox.h"
+#include "hal.h"
+#include "json_writer.h"
+#include "log_arena.h"
+#include "metrics.h"
+#include "status_json.h"
+#include "trace.h"
+
+namespace
+{
+  struct Client
+  {
+    uint32_t id;
+    bool used;
+    bool replayPending;       // a history request wants a log_batch, even an empty one
+    bool saturated;           // send queue found full; nothing is offered until it has room
+    bool throttled;           // budget ran out; ends once it has refilled completely
+    uint32_t saturatedSinceMs;
+    uint32_t logSeq;          // next history record this client gets
+    uint32_t unreportedDrops; // lines lost since its last batch
+    uint32_t tokens;          // byte budget
+    uint32_t refillMs;
+    uint32_t rate;            // budget refill, bytes/s: halved on every stall, raised while it keeps up
+    uint32_t rateChangedMs;
+    OutboxClientStats stats;
+  };
+  Client clients[STATUS_MAX_CLIENTS];
+
+  OutboxTransport transport = {};
+
+  // Dashboard replay buffer: one preallocated arena, records packed by length (see log_arena.h)
+  LogArena<LOG_HISTORY_BYTES> logHistory;
+
+  char frame[LOG_REPLAY_FRAME_BYTES];
+
+  Client *Find(uint32_t id)
+  {
+    for (Client &c : clients)
+      if (c.used && c.id == id)
+        return &c;
+    return nullptr;
+  }
+
+  void Refill(Client &c, uint32_t nowMs)
+  {
+    const uint32_t elapsed = nowMs - c.refillMs;
+    if (elapsed >= 1000u * WS_CLIENT_BURST_BYTES / c.rate)
+    {
+      c.tokens = WS_CLIENT_BURST_BYTES;
+    }
+    else
+    {
+      const uint32_t add = elapsed * c.rate / 1000u;
+      if (add == 0)
+        return; // keep the fraction accruing
+      c.tokens = c.tokens + add > WS_CLIENT_BURST_BYTES ? WS_CLIENT_BURST_BYTES : c.tokens + add;
+    }
+    c.refillMs = nowMs;
+    if (c.tokens == WS_CLIENT_BURST_BYTES)
+      c.throttled = false;
+  }
+
+  // Bytes a frame may use right now, leaving reserve for more urgent frames
+  uint32_t Available(Client &c, uint32_t nowMs, uint32_t reserve)
+  {
+    Refill(c, nowMs);
+    return c.tokens > reserve ? c.tokens - reserve : 0;
+  }
+
+  // Hands one frame to the library if the client's queue has room; the budget was checked by the
+  // caller. A refusal marks the client saturated, so each stall counts once. Its link is slower
+  // than its budget, so the budget is halved (and emptied: the queue is full already); it then
+  // grows back by an eighth of the maximum for every second without a stall. The queue in front
+  // of it thus stays short, and a status frame does not wait behind seconds of logs.
+  bool Deliver(Client &c, const char *data, size_t len, uint32_t nowMs, bool binary = false)
+  {
+    if (!transport.canSend(c.id))
+    {
+      c.saturated = true;
+      c.saturatedSinceMs = nowMs;
+      c.rate = c.rate / 2 > WS_CLIENT_MIN_BYTES_PER_SEC ? c.rate / 2 : WS_CLIENT_MIN_BYTES_PER_SEC;
+      c.rateChangedMs = nowMs;
+      c.tokens = 0;
+      c.refillMs = nowMs;
+      ++c.stats.stalls;
+      MetricsAdd(MetricCounter::WS_FRAMES_DROPPED);
+      TRACE(TraceEvent::WS_SEND, TRACE_WS_REFUSED | (binary ? TRACE_WS_BINARY : 0), len > 0xFFFF ? 0xFFFF : (uint16_t)len, c.id);
+      return false;
+    }
+    transport.send(c.id, data, len, binary);
+    TRACE(TraceEvent::WS_SEND, binary ? TRACE_WS_BINARY : 0, len > 0xFFFF ? 0xFFFF : (uint16_t)len, c.id);
+    c.tokens -= (uint32_t)len;
+    ++c.stats.framesSent;
+    c.stats.bytesSent += (uint32_t)len;
+    MetricsAdd(MetricCounter::WS_FRAMES_SENT);
+    return true;
+  }
+
+  void Throttle(Client &c)
+  {
+    if (c.throttled)
+      return;
+    c.throttled = true;
+    ++c.stats.throttled;
+    MetricsAdd(MetricCounter::WS_CLIENTS_THROTTLED);
+  }
+
+  // Lines evicted from the history before this client got them
+  void CatchUp(Client &c)
+  {
+    const uint32_t first = logHistory.FirstSeq();
+    if ((int32_t)(first - c.logSeq) <= 0)
+      return;
+    const uint32_t lost = first - c.logSeq;
+    c.logSeq = first;
+    c.unreportedDrops += lost;
+    c.stats.logLinesDropped += lost;
+    MetricsAdd(MetricCounter::WS_LOG_LINES_DROPPED, lost);
+  }
+
+  // Builds the next log frame for a client into frame[], at most cap bytes (incl. the NUL).
+  // Returns its length (0: nothing fits) and the sequence number after its last line.
+  size_t BuildLogFrame(const Client &c, size_t cap, uint32_t &nextSeq, bool &oversized)
+  {
+    nextSeq = c.logSeq;
+    oversized = false;
+    const uint32_t pending = logHistory.NextSeq() - c.logSeq;
+
+    // The common case, one fresh line: a plain log frame
+    if (pending == 1 && !c.replayPending && c.unreportedDrops == 0)
+    {
+      JsonWriter w(frame, cap);
+      logHistory.ForEachFrom(c.logSeq, [&](uint32_t seq, uint32_t timestamp, const char *message, size_t len)
+      {
+        WriteLogJson(w, timestamp, message, len);
+        nextSeq = seq + 1;
+        return false;
+      });
+      oversized = !w.Ok() && cap == sizeof(frame);
+      return w.Ok() ? w.Length() : 0;
+    }
+
+    // {"type":"log_batch","dropped":n,"entries":[[timestamp,"message"],...]}
+    constexpr size_t TAIL_LEN = 2; // "]}" closing the entries array and the frame
+    JsonWriter w(frame, cap);
+    w.BeginObject().Field("type", "log_batch");
+    if (c.unreportedDrops)
+      w.Key("dropped").Uint(c.unreportedDrops);
+    w.Key("entries").BeginArray();
+    if (!w.Ok())
+      return 0;
+    size_t entries = 0;
+    logHistory.ForEachFrom(c.logSeq, [&](uint32_t seq, uint32_t timestamp, const char *message, size_t len)
+    {
+      const JsonWriter::Mark mark = w.Save();
+      w.BeginArray().Uint(timestamp).String(message, len).EndArray();
+      if (w.Ok() && w.Length() + TAIL_LEN <= w.Capacity())
+      {
+        ++entries;
+        nextSeq = seq + 1;
+        return true;
+      }
+      w.Rewind(mark);
+      oversized = entries == 0 && cap == sizeof(frame); // larger than any frame; skip it
+      return false;
+    });
+    if (entries == 0 && !c.replayPending && c.unreportedDrops == 0)
+      return 0;
+    w.EndArray().EndObject();
+    return w.Ok() ? w.Length() : 0;
+  }
+
+  void RaiseRate(Client &c, uint32_t nowMs)
+  {
+    if (c.rate >= WS_CLIENT_BYTES_PER_SEC || nowMs - c.rateChangedMs < 1000)
+      return;
+    c.rate += WS_CLIENT_BYTES_PER_SEC / 8;
+    if (c.rate > WS_CLIENT_BYTES_PER_SEC)
+      c.rate = WS_CLIENT_BYTES_PER_SEC;
+    c.rateChangedMs = nowMs;
+  }
+
+  void PumpLogs(Client &c, uint32_t nowMs)
+  {
+    // Batches hold at most ~1/4 s of the client's current rate, so a slow client's queue holds
+    // fewer bytes too
+    const size_t maxFrame = c.rate / 4 > 256 ? c.rate / 4 + 1 : 257;
+    for (;;)
+    {
+      CatchUp(c);
+      if (c.logSeq == logHistory.NextSeq() && !c.replayPending && c.unreportedDrops == 0)
+        return;
+      const uint32_t avail = Available(c, nowMs, WS_CLIENT_STATUS_RESERVE_BYTES);
+      size_t cap = avail + 1 < sizeof(frame) ? avail + 1 : sizeof(frame);
+      if (cap > maxFrame)
+        cap = maxFrame;
+      uint32_t nextSeq = c.logSeq;
+      bool oversized = false;
+      const size_t len = cap > 1 ? BuildLogFrame(c, cap, nextSeq, oversized) : 0;
+      if (oversized)
+      {
+        // Cannot ever be sent; count it as dropped rather than stall the cursor behind it
+        ++c.logSeq;
+        ++c.unreportedDrops;
+        ++c.stats.logLinesDropped;
+        MetricsAdd(MetricCounter::WS_LOG_LINES_DROPPED);
+        continue;
+      }
+      if (len == 0)
+      {
+        Throttle(c);
+        return;
+      }
+      if (!Deliver(c, frame, len, nowMs))
+        return;
+      c.logSeq = nextSeq;
+      c.replayPending = false;
+      c.unreportedDrops = 0;
+    }
+  }
+} // namespace
+
+void OutboxBegin(const OutboxTransport &t)
+{
+  transport = t;
+}
+
+bool OutboxAddClient(uint32_t clientId, uint32_t nowMs)
+{
+  Client *c = Find(clientId);
+  for (size_t i = 0; !c && i < STATUS_MAX_CLIENTS; ++i)
+    if (!clients[i].used)
+      c = &clients[i];
+  if (!c)
+    return false;
+  *c = Client{};
+  c->id = clientId;
+  c->used = true;
+  c->logSeq = logHistory.NextSeq();
+  c->tokens = WS_CLIENT_BURST_BYTES;
+  c->refillMs = nowMs;
+  c->rate = WS_CLIENT_BYTES_PER_SEC;
+  c->rateChangedMs = nowMs;
+  c->stats.id = clientId;
+  return true;
+}
+
+void OutboxRemoveClient(uint32_t clientId)
+{
+  if (Client *c = Find(clientId))
+    c->used = false;
+}
+
+void OutboxLogLine(const char *line, size_t len, uint32_t timestampMs)
+{
+  logHistory.Append(timestampMs, line, len);
+}
+
+void OutboxRequestHistory(uint32_t clientId, uint32_t sinceMs, bool all)
+{
+  Client *c = Find(clientId);
+  if (!c)
+    return;
+  c->logSeq = logHistory.NextSeq();
+  if (all)
+    c->logSeq = logHistory.FirstSeq();
+  else
+    logHistory.ForEachFrom(logHistory.FirstSeq(), [&](uint32_t seq, uint32_t timestamp, const char *, size_t)
+    {
+      if (timestamp <= sinceMs)
+        return true;
+      c->logSeq = seq;
+      return false;
+    });
+  c->unreportedDrops = 0; // a replay starts a fresh view
+  c->replayPending = true;
+}
+
+bool OutboxSend(uint32_t clientId, const char *data, size_t len)
+{
+  Client *c = Find(clientId);
+  if (!c || c->saturated)
+    return false;
+  const uint32_t nowMs = hal::Millis();
+  if (Available(*c, nowMs, 0) < len)
+  {
+    Throttle(*c);
+    return false;
+  }
+  return Deliver(*c, data, len, nowMs);
+}
+
+bool OutboxSendBinary(uint32_t clientId, const uint8_t *data, size_t len)
+{
+  Client *c = Find(clientId);
+  if (!c || c->saturated)
+    return false;
+  const uint32_t nowMs = hal::Millis();
+  if (Available(*c, nowMs, WS_CLIENT_STATUS_RESERVE_BYTES) < len)
+  {
+    Throttle(*c);
+    return false;
+  }
+  return Deliver(*c, (const char *)data, len, nowMs, true);
+}
+
+void OutboxPump(uint32_t nowMs)
+{
+  for (Client &c : clients)
+  {
+    if (!c.used)
+      continue;
+    if (c.saturated && !transport.canSend(c.id))
+    {
+      if (nowMs - c.saturatedSinceMs >= WS_CLIENT_SATURATED_MS)
+      {
+        // Its link is not keeping up; dropping it frees the library's queue for it
+        c.used = false;
+        MetricsAdd(MetricCounter::WS_CLIENTS_DISCONNECTED);
+        transport.close(c.id);
+      }
+      continue;
+    }
+    c.saturated = false;
+    RaiseRate(c, nowMs);
+    PumpLogs(c, nowMs);
+  }
+}
+
+size_t OutboxGetClientStats(OutboxClientStats *out, size_t max, uint32_t nowMs)
+{
+  size_t n = 0;
+  for (const Client &c : clients)
+  {
+    if (!c.used || n >= max)
+      continue;
+    out[n] = c.stats;
+    out[n].logBacklog = logHistory.NextSeq() - c.logSeq;
+    out[n].saturatedMs = c.saturated ? nowMs - c.saturatedSinceMs : 0;
+    out[n].rate = c.rate;
+    ++n;
+  }
+  return n;
+}
+
+OutboxHistoryStats OutboxGetHistoryStats()
+{
+  return OutboxHistoryStats{logHistory.UsedBytes(), logHistory.CapacityBytes(), logHistory.Count()};
+}
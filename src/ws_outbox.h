@@ -0,0 +1,120 @@
+#pragma once
+
+// Per-client outbound flow control for dashboard WebSocket clients. Every frame to a client goes
+// through here, so one client on a weak link can only ever hold up itself:
+//  - each client has a byte budget (token bucket: WS_CLIENT_BURST_BYTES, refilled at up to
+//    WS_CLIENT_BYTES_PER_SEC) that caps what it can have queued in the WebSocket library. A client
+//    whose send queue fills up has its refill rate halved, then raised again while it keeps up,
+//    so the budget settles near what its link actually carries;
+//  - logs are not copied per client: each client keeps a cursor into the shared history arena and
+//    is sent batches from it as its budget allows. A client that falls behind loses the oldest
+//    lines first (evicted from the history under its cursor); the loss is counted and reported to
+//    it in the next batch ({"type":"log_batch","dropped":n,...});
+//  - status frames (status_channel.h) get first call on the budget (logs leave them
+//    WS_CLIENT_STATUS_RESERVE_BYTES), and a refused status frame is never queued: the channel
+//    coalesces it into the next one, so a slow client still gets the latest state;
+//  - a client whose send queue stays full for WS_CLIENT_SATURATED_MS is disconnected.
+// Transport-agnostic like the status channel, so the native build can drive it with fake clients.
+
+#include <stdint.h>
+#include <stddef.h>
+#include "status_channel.h" // STATUS_MAX_CLIENTS: both track the same clients
+
+#ifndef WS_CLIENT_BURST_BYTES
+  #define WS_CLIENT_BURST_BYTES 4096 // most a client can be handed at once
+#endif
+
+#ifndef WS_CLIENT_BYTES_PER_SEC
+  #if defined(ESP8266)
+    #define WS_CLIENT_BYTES_PER_SEC 4096 // sustained rate per client
+  #else
+    #define WS_CLIENT_BYTES_PER_SEC 8192
+  #endif
+#endif
+
+#ifndef WS_CLIENT_MIN_BYTES_PER_SEC
+  #define WS_CLIENT_MIN_BYTES_PER_SEC 512 // floor for a client that keeps stalling
+#endif
+
+#ifndef WS_CLIENT_STATUS_RESERVE_BYTES
+  #define WS_CLIENT_STATUS_RESERVE_BYTES 512 // budget log batches leave for status frames
+#endif
+
+#ifndef WS_CLIENT_SATURATED_MS
+  #define WS_CLIENT_SATURATED_MS 10000 // send queue full this long -> disconnect
+#endif
+
+#ifndef LOG_REPLAY_FRAME_BYTES
+  #define LOG_REPLAY_FRAME_BYTES 1024 // max size of one log batch frame
+#endif
+
+#ifndef LOG_HISTORY_BYTES
+  #if defined(ESP8266)
+    #define LOG_HISTORY_BYTES 3072 // dashboard replay buffer, bytes (not entries)
+  #else
+    #define LOG_HISTORY_BYTES 4096
+  #endif
+#endif
+
+static_assert(LOG_REPLAY_FRAME_BYTES + WS_CLIENT_STATUS_RESERVE_BYTES <= WS_CLIENT_BURST_BYTES,
+              "a full log batch must fit in a client's budget");
+
+// The WebSocket library side, per client id. canSend() is false while the client's send queue is
+// full; send() (a text frame, or a binary one) is only called right after canSend() returned true.
+struct OutboxTransport
+{
+  bool (*canSend)(uint32_t clientId);
+  void (*send)(uint32_t clientId, const char *data, size_t len, bool binary);
+  void (*close)(uint32_t clientId);
+};
+
+struct OutboxClientStats
+{
+  uint32_t id;
+  uint32_t framesSent;
+  uint32_t bytesSent;
+  uint32_t throttled;       // times its budget ran out (status coalesced, logs left in the history)
+  uint32_t stalls;          // times its send queue filled up
+  uint32_t logLinesDropped; // evicted from the history before this client got them
+  uint32_t logBacklog;      // lines waiting for this client
+  uint32_t saturatedMs;     // how long its send queue has been full; 0 if it is not
+  uint32_t rate;            // current budget refill, bytes/s
+};
+
+struct OutboxHistoryStats
+{
+  size_t bytes;
+  size_t capacity;
+  size_t entries;
+};
+
+// Everything below is called from one thread (loop()).
+
+void OutboxBegin(const OutboxTransport &transport);
+
+// New clients start with a full budget and only get log lines appended after they joined. False if
+// no slot is free.
+bool OutboxAddClient(uint32_t clientId, uint32_t nowMs);
+void OutboxRemoveClient(uint32_t clientId);
+
+// Appends to the shared history; clients get it on the next OutboxPump()
+void OutboxLogLine(const char *line, size_t len, uint32_t timestampMs);
+
+// Rewinds a client's log cursor to the history newer than sinceMs (or all of it); the client gets a
+// log_batch frame even if there is nothing to replay
+void OutboxRequestHistory(uint32_t clientId, uint32_t sinceMs, bool all);
+
+// One frame to one client through its budget; false if it was not sent (a StatusSendFn)
+bool OutboxSend(uint32_t clientId, const char *data, size_t len);
+
+// A binary telemetry frame (telemetry.h, a TelemetrySendFn): ranks below status like a log batch,
+// and is left unsent rather than queued when the budget is short
+bool OutboxSendBinary(uint32_t clientId, const uint8_t *data, size_t len);
+
+// Log batches within each client's budget, then disconnects clients saturated for too long; call
+// every loop() pass after the status channel has had its turn
+void OutboxPump(uint32_t nowMs);
+
+// Copies stats for up to max clients; returns how many
+size_t OutboxGetClientStats(OutboxClientStats *out, size_t max, uint32_t nowMs);
+OutboxHistoryStats OutboxGetHistoryStats();